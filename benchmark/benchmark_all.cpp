@@ -2,4 +2,6 @@
 #define ANKERL_NANOBENCH_IMPLEMENT
 
 #include "pb.hpp"
+// #include "http_server.hpp"
+#include "io_backend.hpp"
 
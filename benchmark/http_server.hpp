@@ -0,0 +1,126 @@
+#pragma once
+
+#include <jkl/util/log.hpp>
+#include <jkl/http_server.hpp>
+#define DOCTEST_CONFIG_TREAT_CHAR_STAR_AS_STRING
+#include <doctest/doctest.h>
+#include <thread>
+
+
+// wrk style: N keep-alive connections hammer a local server for a fixed duration
+TEST_SUITE("http_server benchmark"){
+
+using namespace jkl;
+
+
+struct http_bench_result
+{
+    std::atomic_size_t requests = 0;
+    std::atomic_size_t errors   = 0;
+    std::atomic_size_t running  = 0;
+};
+
+using http_bench_conn = http_conn_t<beast::basic_stream<asio::ip::tcp, asio::io_context::executor_type>,
+                                    http::request<http::empty_body>, http::response<http::string_body>, flat_buffer>;
+
+// pipeline: requests sent before reading responses
+inline atask<> http_bench_client(asio::io_context& ioc, asio::ip::tcp::endpoint ep, size_t pipeline,
+                                 std::chrono::steady_clock::time_point deadline, http_bench_result& r)
+{
+    http_bench_conn conn(ioc.get_executor());
+
+    if(! co_await conn.connect_endpoint(ep))
+    {
+        ++r.errors;
+        --r.running;
+        co_return;
+    }
+
+    conn.req.method(http::verb::get);
+    conn.req.target("/");
+    conn.req.version(11);
+    conn.req.set(http::field::host, "localhost");
+    conn.req.keep_alive(true);
+
+    bool ok = true;
+
+    while(ok && std::chrono::steady_clock::now() < deadline)
+    {
+        for(size_t i = 0; ok && i < pipeline; ++i)
+            ok = static_cast<bool>(co_await conn.write_req());
+
+        for(size_t i = 0; ok && i < pipeline; ++i)
+        {
+            conn.res = {};
+
+            if((ok = static_cast<bool>(co_await conn.read_res())))
+                ++r.requests;
+        }
+    }
+
+    if(! ok)
+        ++r.errors;
+
+    --r.running;
+}
+
+inline void run_http_bench(char const* name, size_t serverThreads, size_t connections, size_t pipeline,
+                           std::chrono::seconds dur = std::chrono::seconds(3))
+{
+    ioc_pool srvIocs(serverThreads);
+    ioc_pool cliIocs(2);
+
+    http_server server(srvIocs, [](auto& /*req*/, auto& res){
+        res.set(http::field::content_type, "text/plain");
+        res.body() = "Hello, World!";
+    });
+
+    asio::ip::tcp::endpoint ep{asio::ip::make_address("127.0.0.1"), 18080};
+    server.listen(ep).throw_on_error();
+
+    srvIocs.start(serverThreads);
+    cliIocs.start(2);
+
+    std::stop_source stop;
+    auto st = server.run();
+    std::thread srvThread([&](){ st.start_join(stop); });
+
+    http_bench_result r;
+    r.running = connections;
+
+    auto deadline = std::chrono::steady_clock::now() + dur;
+
+    for(size_t i = 0; i < connections; ++i)
+    {
+        auto& ioc = cliIocs.get_ioc();
+        asio::post(ioc, [&, &ioc = ioc](){ spawn(http_bench_client(ioc, ep, pipeline, deadline, r)); });
+    }
+
+    while(r.running.load())
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    stop.request_stop();
+    srvThread.join();
+
+    cliIocs.join();
+    srvIocs.join();
+
+    auto secs = std::chrono::duration<double>(dur).count();
+
+    JKL_LOG << name << ": " << static_cast<double>(r.requests.load()) / secs << " req/s, "
+            << r.errors.load() << " errors";
+}
+
+
+TEST_CASE("http_server keep-alive"){
+    run_http_bench("1 thread , 64 conns", 1, 64, 1);
+    run_http_bench("4 threads, 64 conns", 4, 64, 1);
+}
+
+TEST_CASE("http_server pipelining"){
+    run_http_bench("1 thread , 64 conns, pipeline 16", 1, 64, 16);
+    run_http_bench("4 threads, 64 conns, pipeline 16", 4, 64, 16);
+}
+
+
+} // TEST_SUITE("http_server benchmark")
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <jkl/util/log.hpp>
+#include <jkl/ioc.hpp>
+#include <jkl/file.hpp>
+#include <jkl/task.hpp>
+#include <jkl/ec_awaiter.hpp>
+#include <jkl/read_write.hpp>
+#include <jkl/async_file.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#define DOCTEST_CONFIG_TREAT_CHAR_STAR_AS_STRING
+#include <doctest/doctest.h>
+#include <vector>
+#include <thread>
+#include <cstdio>
+
+
+// compares I/O backends of ioc.hpp, build with and without ${PROJECT_NAME}_USE_IO_URING(_FOR_SOCKETS)
+TEST_SUITE("io backend benchmark"){
+
+using namespace jkl;
+
+
+struct io_bench_result
+{
+    std::atomic_size_t bytes   = 0;
+    std::atomic_size_t errors  = 0;
+    std::atomic_size_t running = 0;
+};
+
+using io_bench_socket   = asio::basic_stream_socket<asio::ip::tcp, asio::io_context::executor_type>;
+using io_bench_acceptor = asio::basic_socket_acceptor<asio::ip::tcp, asio::io_context::executor_type>;
+
+// echos back whatever received
+inline atask<> io_bench_echo(io_bench_socket s, size_t msgSize)
+{
+    std::vector<char> buf(msgSize);
+
+    for(;;)
+    {
+        auto r = co_await read_some(s, asio::buffer(buf));
+        if(! r)
+            break;
+
+        if(! co_await write_all(s, asio::buffer(buf.data(), *r)))
+            break;
+    }
+}
+
+// ping-pong with msgSize messages
+inline atask<> io_bench_client(asio::io_context& ioc, asio::ip::tcp::endpoint ep, size_t msgSize,
+                               std::chrono::steady_clock::time_point deadline, io_bench_result& r)
+{
+    io_bench_socket s(ioc.get_executor());
+
+    if(! co_await make_ec_awaiter<void>(s, [&](auto&& h){ s.async_connect(ep, std::move(h)); }))
+    {
+        ++r.errors;
+        --r.running;
+        co_return;
+    }
+
+    s.set_option(asio::ip::tcp::no_delay(true));
+
+    std::vector<char> buf(msgSize, 'x');
+    bool ok = true;
+
+    while(ok && std::chrono::steady_clock::now() < deadline)
+    {
+        ok = static_cast<bool>(co_await write_all(s, asio::buffer(buf)));
+
+        for(size_t n = 0; ok && n < msgSize;)
+        {
+            auto rd = co_await read_some(s, asio::buffer(buf.data() + n, msgSize - n));
+
+            if((ok = static_cast<bool>(rd)))
+                n += *rd;
+        }
+
+        if(ok)
+            r.bytes += msgSize;
+    }
+
+    if(! ok)
+        ++r.errors;
+
+    aerror_code e;
+    s.shutdown(asio::socket_base::shutdown_both, e);
+    --r.running;
+}
+
+inline void run_loopback_bench(char const* name, size_t connections, size_t msgSize,
+                               std::chrono::seconds dur = std::chrono::seconds(3))
+{
+    // one thread per io_context, so the backend can skip locking
+    ioc_pool srvIocs(1, ioc_single_thread_hint);
+    ioc_pool cliIocs(1, ioc_single_thread_hint);
+
+    io_bench_acceptor acceptor(srvIocs.get_ioc(0).get_executor(), {asio::ip::make_address("127.0.0.1"), 0});
+    auto ep = acceptor.local_endpoint();
+
+    auto acceptLoop = [](io_bench_acceptor& a, size_t n, size_t msgSize) -> atask<>
+    {
+        for(; n; --n)
+        {
+            auto s = co_await make_ec_awaiter<io_bench_socket>(a, [&](auto&& h){ a.async_accept(std::move(h)); });
+            if(! s)
+                break;
+
+            s->set_option(asio::ip::tcp::no_delay(true));
+            spawn(io_bench_echo(std::move(*s), msgSize));
+        }
+    };
+
+    asio::post(srvIocs.get_ioc(0), [&](){ spawn(acceptLoop(acceptor, connections, msgSize)); });
+
+    srvIocs.start(1);
+    cliIocs.start(1);
+
+    io_bench_result r;
+    r.running = connections;
+
+    auto deadline = std::chrono::steady_clock::now() + dur;
+
+    for(size_t i = 0; i < connections; ++i)
+    {
+        asio::post(cliIocs.get_ioc(0), [&](){ spawn(io_bench_client(cliIocs.get_ioc(0), ep, msgSize, deadline, r)); });
+    }
+
+    while(r.running.load())
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    cliIocs.join();
+    srvIocs.join();
+
+    auto secs = std::chrono::duration<double>(dur).count();
+
+    JKL_LOG << ioc_backend_name() << ", " << name << ": "
+            << static_cast<double>(r.bytes.load()) / secs / (1024 * 1024) << " MiB/s, "
+            << r.errors.load() << " errors";
+}
+
+
+TEST_CASE("loopback ping-pong"){
+    run_loopback_bench("16 conns, 64B"  , 16, 64);
+    run_loopback_bench("16 conns, 4KiB" , 16, 4 * 1024);
+    run_loopback_bench("16 conns, 64KiB", 16, 64 * 1024);
+}
+
+
+TEST_CASE("file read"){
+    char const* path = "io_backend_bench.tmp";
+    size_t const fileSize = 256 * 1024 * 1024;
+    size_t const blkSize  = 64 * 1024;
+
+    {
+        synced_file f;
+        f.open(path, file_mode::write).throw_on_error();
+
+        std::vector<char> blk(blkSize, 'x');
+
+        for(size_t n = 0; n < fileSize; n += blkSize)
+            f.write(blk).throw_on_error();
+    }
+
+    std::vector<char> buf(blkSize);
+
+    auto report = [&](char const* name, auto start, size_t n)
+    {
+        auto secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        JKL_LOG << ioc_backend_name() << ", " << name << ": " << static_cast<double>(n) / secs / (1024 * 1024) << " MiB/s";
+    };
+
+    {
+        synced_file f;
+        f.open(path, file_mode::read).throw_on_error();
+
+        auto   start = std::chrono::steady_clock::now();
+        size_t total = 0;
+
+        for(;;)
+        {
+            auto n = f.read(buf.data(), buf.size());
+            n.throw_on_error();
+
+            if(*n == 0)
+                break;
+
+            total += *n;
+        }
+
+        CHECK(total == fileSize);
+        report("synced_file 64KiB reads", start, total);
+    }
+
+    // qd: reads in flight
+    auto asyncRead = [&](char const* name, size_t qd)
+    {
+        ioc_pool iocs(1, ioc_single_thread_hint);
+        async_file f(iocs.get_ioc(0).get_executor());
+        f.open(path, file_mode::read).throw_on_error();
+
+        std::vector<std::vector<char>> bufs(qd, std::vector<char>(blkSize));
+        std::atomic_size_t total = 0;
+        uint64_t next = 0; // offset of next block, only touched on the io thread
+
+        auto reader = [&](std::vector<char>& b) -> atask<>
+        {
+            while(next < fileSize)
+            {
+                uint64_t off = next;
+                next += blkSize;
+
+                auto n = co_await f.read_at(off, b);
+                if(! n || *n == 0)
+                    break;
+
+                total += *n;
+                b.resize(blkSize);
+            }
+        };
+
+        auto start = std::chrono::steady_clock::now();
+
+        asio::post(iocs.get_ioc(0), [&](){
+            for(auto& b : bufs)
+                spawn(reader(b));
+        });
+
+        iocs.start(1);
+        iocs.join();
+
+        CHECK(total.load() == fileSize);
+        report(name, start, total.load());
+    };
+
+    asyncRead("async_file 64KiB reads, qd 1" , 1);
+    asyncRead("async_file 64KiB reads, qd 16", 16);
+
+    std::remove(path);
+}
+
+
+} // TEST_SUITE("io backend benchmark")
@@ -107,6 +107,147 @@ TEST_CASE("varint decode benchmark"){
 } // TEST_CASE("varint decode benchmark")
 
 
+TEST_CASE("packed varint decode benchmark"){
+
+    // read_varints() only beats read_varint() on runs of same length varints,
+    // pb_repeated_fld uses it only when packed varints start with such a run.
+    auto run = [](char const* title, auto&& gen)
+    {
+        nanobench::Bench b;
+        b.title(title)
+            .relative(true)
+            .warmup(100)
+            .minEpochIterations(2000)
+            ;
+
+        std::vector<int64_t> vals;
+        for(int i = 0; i < 4096; ++i)
+            vals.emplace_back(gen(i));
+
+        std::vector<uint8_t> buf;
+        for(auto v : vals)
+            append_varint(buf, v);
+
+        std::vector<int64_t> out;
+
+        b.run("google ReadVarint64", [&]{
+            out.clear();
+            out.reserve(vals.size());
+            google::protobuf::io::CodedInputStream s{buf.data(), (int)buf.size()};
+            uint64_t v;
+            while(s.ReadVarint64(&v))
+                out.emplace_back(static_cast<int64_t>(v));
+            nanobench::doNotOptimizeAway(out.data());
+        });
+
+        b.run("jkl read_varint", [&]{
+            out.clear();
+            out.reserve(vals.size());
+            auto* p = buf.data();
+            auto* e = buf.data() + buf.size();
+            while(p < e)
+            {
+                int64_t v;
+                p = read_varint(p, e, v).value();
+                out.emplace_back(v);
+            }
+            nanobench::doNotOptimizeAway(out.data());
+        });
+
+        b.run("jkl count_varints + read_varints", [&]{
+            out.resize(count_varints(buf.data(), buf.data() + buf.size()));
+            nanobench::doNotOptimizeAway(
+                read_varints<false, int64_t>(buf.data(), buf.data() + buf.size(), out.data(), out.size()));
+        });
+
+        CHECK(out == vals);
+    };
+
+    run("packed varint decode, 1 byte", [](int i){ return int64_t(i % 128); });
+    run("packed varint decode, 2 bytes", [](int i){ return int64_t(128 + i); });
+    // telemetry like: mostly small deltas, some larger and negative values
+    run("packed varint decode, mixed", [](int i){ return int64_t((i % 10 < 6) ? i % 100 : (i % 10 < 9) ? 1000 + i : -i); });
+
+} // TEST_CASE("packed varint decode benchmark")
+
+
+// Str: type of string fields, e.g.: std::pmr::string to read with pb_arena
+template<class Str>
+struct GoogleMessage1SubMessage_t
+{
+    constexpr bool operator==(GoogleMessage1SubMessage_t const&) const = default;
+
+    int32_t field1 = 0;
+    int32_t field2 = 0;
+    int32_t field3 = 0;
+    Str field15;
+    bool field12 = true;
+    std::optional<int64_t> field13;
+    std::optional<int64_t> field14;
+    std::optional<int32_t> field16;
+    int32_t field19 = 2;
+    bool field20 = true;
+    bool field28 = true;
+    std::optional<uint64_t> field21;
+    std::optional<int32_t > field22;
+    bool field23  = false;
+    bool field206 = false;
+    std::optional<uint32_t> field203;
+    std::optional<int32_t > field204;
+    Str field205;
+    std::optional<uint64_t> field207;
+    std::optional<uint64_t> field300;
+};
+
+template<class Str>
+struct GoogleMessage1_t
+{
+    bool operator==(GoogleMessage1_t const&) const noexcept = default;
+
+    Str field1;
+    Str field9;
+    Str field18;
+    bool field80 = false;
+    bool field81 = true;
+    int32_t field2;
+    int32_t field3;
+    std::optional<int32_t> field280;
+    int32_t field6 = 0;
+    std::optional<int64_t> field22;
+    Str field4;
+    std::vector<uint64_t> field5;
+    bool field59 = false;
+    Str field7;
+    std::optional<int32_t> field16;
+    int32_t field130 = 0;
+    bool field12 = true;
+    bool field17 = true;
+    bool field13 = true;
+    bool field14 = true;
+    int32_t field104 = 0;
+    int32_t field100 = 0;
+    int32_t field101 = 0;
+    Str field102;
+    Str field103;
+    int32_t field29 = 0;
+    bool    field30 = false;
+    int32_t field60 = -1;
+    int32_t field271 = -1;
+    int32_t field272 = -1;
+    std::optional<int32_t> field150;
+    int32_t field23 = 0;
+    bool    field24 = false;
+    int32_t field25 = 0;
+    std::optional<GoogleMessage1SubMessage_t<Str>> field15;
+    std::optional<bool> field78;
+    int32_t field67 = 0;
+    std::optional<int32_t> field68;
+    int32_t field128 = 0;
+    Str     field129 = "xxxxxxxxxxxxxxxxxxxxx";
+    int32_t field131 = 0;
+};
+
+
 TEST_CASE("GoogleMessage1"){
 
     constexpr uint8_t data[] = {
@@ -127,32 +268,6 @@ TEST_CASE("GoogleMessage1"){
         0x61, 0xA0, 0x06, 0x1F
     };
 
-    struct GoogleMessage1SubMessage_t
-    {
-        constexpr bool operator==(GoogleMessage1SubMessage_t const&) const = default;
-
-        int32_t field1 = 0;
-        int32_t field2 = 0;
-        int32_t field3 = 0;
-        string field15;
-        bool field12 = true;
-        std::optional<int64_t> field13;
-        std::optional<int64_t> field14;
-        std::optional<int32_t> field16;
-        int32_t field19 = 2;
-        bool field20 = true;
-        bool field28 = true;
-        std::optional<uint64_t> field21;
-        std::optional<int32_t > field22;
-        bool field23  = false;
-        bool field206 = false;
-        std::optional<uint32_t> field203;
-        std::optional<int32_t > field204;
-        string field205;
-        std::optional<uint64_t> field207;
-        std::optional<uint64_t> field300;
-    };
-
     constexpr auto GoogleMessage1SubMessage = pb_message<"GoogleMessage1SubMessage">(
         pb_int32  <"field1"  , 1  >(JKL_P_VAL(d.field1  ), p_default(0)),
         pb_int32  <"field2"  , 2  >(JKL_P_VAL(d.field2  ), p_default(0)),
@@ -176,53 +291,6 @@ TEST_CASE("GoogleMessage1"){
         pb_uint64 <"field300", 300>(JKL_P_VAL(d.field300), p_optional)
     );
 
-    struct GoogleMessage1_t
-    {
-        bool operator==(GoogleMessage1_t const&) const noexcept = default;
-
-        string field1;
-        string field9;
-        string field18;
-        bool field80 = false;
-        bool field81 = true;
-        int32_t field2;
-        int32_t field3;
-        std::optional<int32_t> field280;
-        int32_t field6 = 0;
-        std::optional<int64_t> field22;
-        string field4;
-        std::vector<uint64_t> field5;
-        bool field59 = false;
-        string field7;
-        std::optional<int32_t> field16;
-        int32_t field130 = 0;
-        bool field12 = true;
-        bool field17 = true;
-        bool field13 = true;
-        bool field14 = true;
-        int32_t field104 = 0;
-        int32_t field100 = 0;
-        int32_t field101 = 0;
-        string field102;
-        string field103;
-        int32_t field29 = 0;
-        bool    field30 = false;
-        int32_t field60 = -1;
-        int32_t field271 = -1;
-        int32_t field272 = -1;
-        std::optional<int32_t> field150;
-        int32_t field23 = 0;
-        bool    field24 = false;
-        int32_t field25 = 0;
-        std::optional<GoogleMessage1SubMessage_t> field15;
-        std::optional<bool> field78;
-        int32_t field67 = 0;
-        std::optional<int32_t> field68;
-        int32_t field128 = 0;
-        string  field129 = "xxxxxxxxxxxxxxxxxxxxx";
-        int32_t field131 = 0;
-    };
-
     constexpr auto GoogleMessage1 = pb_message<"GoogleMessage1">(
         pb_string  <"field1"  , 1  >(JKL_P_VAL(d.field1  ), JKL_P_CHECK(exam_utf8(d.field1))),
         pb_string  <"field9"  , 9  >(JKL_P_VAL(d.field9  ), p_optional, JKL_P_CHECK(exam_utf8(d.field9))),
@@ -274,7 +342,7 @@ TEST_CASE("GoogleMessage1"){
     CHECK(gm.ParseFromArray(data, sizeof(data)));
     CHECK(gm.SerializeToString(&buf));
 
-    GoogleMessage1_t m;
+    GoogleMessage1_t<string> m;
     CHECK(GoogleMessage1.full_read(data, m));
     CHECK_NOTHROW(GoogleMessage1.write(buf, m));
 
@@ -312,10 +380,158 @@ TEST_CASE("GoogleMessage1"){
         b.run("jkl.pb", [&]{
             nanobench::doNotOptimizeAway(GoogleMessage1.full_read(data, m));
         });
+
+        // m above is reused, so its strings are only allocated once, these read into a fresh one each time
+        b.run("jkl.pb, new value", [&]{
+            GoogleMessage1_t<string> nm;
+            nanobench::doNotOptimizeAway(GoogleMessage1.full_read(data, nm));
+        });
+
+        constexpr auto GoogleMessage1Proj = GoogleMessage1.project<"field1", "field2", "field15">();
+
+        b.run("jkl.pb, 3 fields projected", [&]{
+            nanobench::doNotOptimizeAway(GoogleMessage1Proj.full_read(data, m));
+        });
+
+        pb_arena arena;
+
+        b.run("jkl.pb, new value, pb_arena", [&]{
+            {
+                GoogleMessage1_t<std::pmr::string> nm;
+                nanobench::doNotOptimizeAway(GoogleMessage1.full_read(data, nm, arena));
+            }
+            arena.release();
+        });
     }
 
     //system("pause");
 } // TEST_CASE("GoogleMessage1")
 
 
+TEST_CASE("large message write benchmark"){
+
+    struct point_t
+    {
+        double  x, y;
+        string  label;
+    };
+
+    struct polyline_t
+    {
+        std::vector<point_t> points;
+        std::vector<int64_t> deltas;
+    };
+
+    constexpr auto point = pb_message<"point">(
+        pb_double<"x"    , 1>(JKL_P_VAL(d.x)),
+        pb_double<"y"    , 2>(JKL_P_VAL(d.y)),
+        pb_string<"label", 3>(JKL_P_VAL(d.label))
+    );
+
+    constexpr auto polyline = pb_message<"polyline">(
+        pb_repeated(point._<"points", 1>(), JKL_P_VAL(d.points)),
+        pb_repeated(pb_int64<"deltas", 2>(), JKL_P_VAL(d.deltas))
+    );
+
+    // ~8MB on wire
+    polyline_t d;
+    for(int i = 0; i < 200'000; ++i)
+        d.points.push_back({i * 0.5, i * 1.5, "p" + std::to_string(i)});
+    for(int i = 0; i < 1'000'000; ++i)
+        d.deltas.push_back((i % 10 < 8) ? i % 100 : i * 997);
+
+    nanobench::Bench b;
+    b.title("large message write")
+        .relative(true)
+        .warmup(3)
+        .minEpochIterations(10)
+        ;
+
+    b.run("jkl write(string)", [&]{
+        string buf;
+        polyline.write(buf, d);
+        nanobench::doNotOptimizeAway(buf.data());
+    });
+
+    pb_chain_buf<> c;
+
+    b.run("jkl write(pb_chain_buf)", [&]{
+        c.clear();
+        polyline.write(c, d);
+        nanobench::doNotOptimizeAway(c.byte_size());
+    });
+
+} // TEST_CASE("large message write benchmark")
+
+
+TEST_CASE("arena read benchmark"){
+
+    struct point_t
+    {
+        double              x, y;
+        string              label;
+        std::vector<string> tags;
+    };
+
+    struct polyline_t
+    {
+        std::vector<point_t> points;
+    };
+
+    struct pmr_point_t
+    {
+        double                             x, y;
+        std::pmr::string                   label;
+        std::pmr::vector<std::pmr::string> tags;
+    };
+
+    struct pmr_polyline_t
+    {
+        std::pmr::vector<pmr_point_t> points;
+    };
+
+    constexpr auto point = pb_message<"point">(
+        pb_double<"x"    , 1>(JKL_P_VAL(d.x)),
+        pb_double<"y"    , 2>(JKL_P_VAL(d.y)),
+        pb_string<"label", 3>(JKL_P_VAL(d.label)),
+        pb_repeated(pb_string<"tags", 4>(), JKL_P_VAL(d.tags))
+    );
+
+    constexpr auto polyline = pb_message<"polyline">(
+        pb_repeated(point._<"points", 1>(), JKL_P_VAL(d.points))
+    );
+
+    polyline_t d;
+    for(int i = 0; i < 10'000; ++i)
+        d.points.push_back({i * 0.5, i * 1.5, "label of point " + std::to_string(i),
+                            {"a tag which doesn't fit in sso", "t" + std::to_string(i % 7)}});
+
+    string buf;
+    polyline.write(buf, d);
+
+    nanobench::Bench b;
+    b.title("arena read")
+        .relative(true)
+        .warmup(3)
+        .minEpochIterations(10)
+        ;
+
+    b.run("jkl read", [&]{
+        polyline_t r;
+        nanobench::doNotOptimizeAway(polyline.full_read(buf, r));
+    });
+
+    pb_arena arena(1024 * 1024);
+
+    b.run("jkl read, pb_arena", [&]{
+        {
+            pmr_polyline_t r;
+            nanobench::doNotOptimizeAway(polyline.full_read(buf, r, arena));
+        }
+        arena.release();
+    });
+
+} // TEST_CASE("arena read benchmark")
+
+
 } // TEST_SUITE("pb")
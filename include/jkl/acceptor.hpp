@@ -3,24 +3,42 @@
 #include <jkl/config.hpp>
 #include <jkl/ioc.hpp>
 #include <jkl/buf.hpp>
+#include <jkl/traits.hpp>
+#include <jkl/result.hpp>
 #include <jkl/ec_awaiter.hpp>
 #include <boost/asio/basic_socket_acceptor.hpp>
+#include <boost/asio/detail/socket_option.hpp>
+#include <deque>
+#if defined(__linux__)
+#   include <linux/filter.h>
+#   include <sys/socket.h>
+#endif
 
 
 namespace jkl{
 
 
+#ifdef SO_REUSEPORT
+// allows multiple sockets to bind to the same address, the kernel will distribute connections among them
+using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+
 template<
     class Protocol,
-    class DefultSocket,
-    class Executor = asio::executor,
+    class DefultSocket = typename Protocol::socket,
+    class Executor = asio::executor
 >
-class acceptor_t : public asio::ip::basic_socket_acceptor<Protocol, Executor>
+class acceptor_t : public asio::basic_socket_acceptor<Protocol, Executor>
 {
-    using base = asio::ip::basic_socket_acceptor<Protocol, Executor>;
+    using base = asio::basic_socket_acceptor<Protocol, Executor>;
 
 public:
-    using default_socket_type = rebind_executor_t<DefultSocket, Executor>;
+    using typename base::protocol_type;
+    using typename base::endpoint_type;
+    using typename base::native_handle_type;
+
+    using default_socket_type = typename DefultSocket::template rebind_executor<Executor>::other;
 
     using base::base;
     using base::operator=;
@@ -33,7 +51,7 @@ public:
     template<class... P>
     auto accept(P... p)
     {
-        return make_ec_awaiter<default_socket_type>(
+        return make_ec_awaiter<default_socket_type>(*this,
             [&](auto&& h){ base::async_accept(std::move(h)); },
 
 //             [&, peer = std::make_unique<default_socket_type>(base::get_executor())](auto&& h)
@@ -53,8 +71,8 @@ public:
     template<class... P>
     auto accept(endpoint_type& peerEp, P... p)
     {
-        return make_ec_awaiter<default_socket_type>(
-            [&](auto&& h){ base::async_accept(exc, peerEp, std::move(h)); },
+        return make_ec_awaiter<default_socket_type>(*this,
+            [&](auto&& h){ base::async_accept(peerEp, std::move(h)); },
             p...
         );
     }
@@ -63,7 +81,7 @@ public:
     template<class ExC, class... P>
     auto accept_exc(ExC&& exc, P... p)
     {
-        return make_ec_awaiter<typename default_socket_type::rebind_executor<ExC>::type>(
+        return make_ec_awaiter<typename default_socket_type::template rebind_executor<executor_t<ExC>>::other>(*this,
             [&](auto&& h){ base::async_accept(exc, std::move(h)); },
             p...
         );
@@ -72,7 +90,7 @@ public:
     template<class ExC, class... P>
     auto accept_exc(ExC&& exc, endpoint_type& peerEp, P... p)
     {
-        return make_ec_awaiter<typename default_socket_type::rebind_executor<ExC>::type>(
+        return make_ec_awaiter<typename default_socket_type::template rebind_executor<executor_t<ExC>>::other>(*this,
             [&](auto&& h){ base::async_accept(exc, peerEp, std::move(h)); },
             p...
         );
@@ -81,7 +99,7 @@ public:
     template<class Socket, class... P>
     auto accept_peer(Socket& peer, P... p)
     {
-        return make_ec_awaiter(
+        return make_ec_awaiter<void>(*this,
             [&](auto&& h){ base::async_accept(get_lowest_layer(peer), std::move(h)); },
             p...
         );
@@ -90,7 +108,7 @@ public:
     template<class Socket, class... P>
     auto accept_peer(Socket& peer, endpoint_type& peerEp, P... p)
     {
-        return make_ec_awaiter(
+        return make_ec_awaiter<void>(*this,
             [&](auto&& h){ base::async_accept(get_lowest_layer(peer), peerEp, std::move(h)); },
             p...
         );
@@ -98,4 +116,137 @@ public:
 };
 
 
+
+// one listener per io_context of an ioc_pool, all bound to the same address with SO_REUSEPORT,
+// so the kernel distributes connections among them, and each accepts on its own io_context.
+// falls back to a single listener which distributes accepted sockets to io_contexts round robin,
+// if SO_REUSEPORT is not available.
+template<class Protocol, class DefultSocket = typename Protocol::socket>
+class multi_acceptor
+{
+public:
+    using executor_type = asio::io_context::executor_type;
+    using acceptor_type = acceptor_t<Protocol, DefultSocket, executor_type>;
+    using socket_type   = typename acceptor_type::default_socket_type;
+    using protocol_type = Protocol;
+    using endpoint_type = typename Protocol::endpoint;
+
+private:
+    ioc_pool& _iocs;
+    std::deque<acceptor_type> _acceptors; // i-th listens on i-th io_context
+
+public:
+    explicit multi_acceptor(ioc_pool& iocs) : _iocs{iocs} {}
+
+    ioc_pool& iocs() noexcept { return _iocs; }
+
+    // number of listeners
+    size_t size() const noexcept { return _acceptors.size(); }
+    acceptor_type& get(size_t i) noexcept { BOOST_ASSERT(i < size()); return _acceptors[i]; }
+
+    // whether each io_context has its own listener
+    bool per_ioc() const noexcept { return _acceptors.size() == _iocs.ioc_cnt(); }
+
+    // if ep has port 0, the port picked for the first listener is used by all others.
+    aresult<> listen(endpoint_type ep, int backlog = asio::socket_base::max_listen_connections)
+    {
+        BOOST_ASSERT(_acceptors.empty());
+
+#ifdef SO_REUSEPORT
+        size_t n = _iocs.ioc_cnt();
+#else
+        size_t n = 1;
+#endif
+
+        for(size_t i = 0; i < n; ++i)
+        {
+            auto& a = _acceptors.emplace_back(_iocs.get_ioc(i).get_executor());
+
+            aerror_code e;
+
+            a.open(ep.protocol(), e);
+            if(! e) a.set_option(asio::socket_base::reuse_address(true), e);
+#ifdef SO_REUSEPORT
+            if(! e) a.set_option(reuse_port(true), e);
+#endif
+            if(! e) a.bind(ep, e);
+            if(! e) a.listen(backlog, e);
+            if(! e && i == 0 && ep.port() == 0) ep = a.local_endpoint(e);
+
+            if(e)
+            {
+                _acceptors.clear();
+                return e;
+            }
+        }
+
+        return no_err;
+    }
+
+    // i-th listener prefers connections received on cpu firstCpu + i (SO_INCOMING_CPU, linux 6.2+),
+    // works best when threads of i-th io_context are pinned to that cpu.
+    aresult<> steer_by_incoming_cpu(int firstCpu = 0)
+    {
+#if defined(SO_INCOMING_CPU)
+        for(size_t i = 0; i < _acceptors.size(); ++i)
+        {
+            aerror_code e;
+            _acceptors[i].set_option(asio::detail::socket_option::integer<SOL_SOCKET, SO_INCOMING_CPU>(firstCpu + static_cast<int>(i)), e);
+            if(e)
+                return e;
+        }
+        return no_err;
+#else
+        (void)firstCpu;
+        return aerrc::operation_not_supported;
+#endif
+    }
+
+    // attaches a classic BPF program to the reuseport group, which selects listener by cpu % size()
+    // (SO_ATTACH_REUSEPORT_CBPF, linux 4.5+). Must be called after listen().
+    aresult<> steer_by_cpu_bpf()
+    {
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+        BOOST_ASSERT(_acceptors.size());
+
+        sock_filter code[] = {
+            {BPF_LD  | BPF_W | BPF_ABS, 0, 0, static_cast<__u32>(SKF_AD_OFF + SKF_AD_CPU)}, // A = cpu
+            {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<__u32>(_acceptors.size())     }, // A %= size()
+            {BPF_RET | BPF_A          , 0, 0, 0                                         }  // return A
+        };
+
+        sock_fprog prog{static_cast<unsigned short>(std::size(code)), code};
+
+        if(::setsockopt(_acceptors.front().native_handle(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)))
+            return aerror_code(errno, asio::error::get_system_category());
+        return no_err;
+#else
+        return aerrc::operation_not_supported;
+#endif
+    }
+
+    endpoint_type local_endpoint() const
+    {
+        BOOST_ASSERT(_acceptors.size());
+        return _acceptors.front().local_endpoint();
+    }
+
+    // accepts on i-th listener, the returned socket is bound to i-th io_context,
+    // or next io_context of round robin if ! per_ioc().
+    template<class... P>
+    auto accept(size_t i, P... p)
+    {
+        return get(i).accept_exc(per_ioc() ? _iocs.get_ioc(i) : _iocs.get_ioc(), p...);
+    }
+
+    void close()
+    {
+        for(auto& a : _acceptors)
+        {
+            aerror_code e;
+            a.close(e);
+        }
+    }
+};
+
 } // namespace jkl
@@ -1,11 +1,29 @@
 #pragma once
 
 #include <jkl/config.hpp>
+#include <jkl/ioc.hpp>
+#include <jkl/task.hpp>
 #include <jkl/error.hpp>
+#include <jkl/result.hpp>
+#include <jkl/ec_awaiter.hpp>
 #include <jkl/util/str.hpp>
 #include <jkl/util/endian.hpp>
 #include <jkl/util/concepts.hpp>
+#include <jkl/util/stringify.hpp>
+#include <jkl/util/unordered_map_set.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
 #include <ares.h>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <climits>
+#include <functional>
 
 
 namespace jkl{
@@ -24,7 +42,7 @@ inline auto& ares_category()
 {
 // 	static ares_error_category category;
 // 	return category;
-    return g_ares_error_category;
+    return g_ares_category;
 }
 
 inline aerror_code make_ares_error(int c)
@@ -56,7 +74,7 @@ class ares_opts
     }
 
 public:
-    ares_opts() = default;
+    ares_opts() noexcept : _o{} {}
     ares_opts(ares_options& o, int m) : _o(o), _m(m) {}
 
     int mask() noexcept { return _m; }
@@ -75,6 +93,21 @@ public:
 
     void set_ednspsz(int bytes) noexcept { set_bit_if(_o.ednspsz = bytes, ARES_OPT_EDNSPSZ); _o.flags |= ARES_FLAG_EDNS; }
 
+    // round robin nameservers for each lookup, instead of always starting from the first one.
+    // off overrides "options rotate" of resolv.conf too.
+    void set_rotate(bool on = true) noexcept
+    {
+        set_bit_if(  on, ARES_OPT_ROTATE  );
+        set_bit_if(! on, ARES_OPT_NOROTATE);
+    }
+
+    void set_sock_state_cb(ares_sock_state_cb cb, void* data) noexcept
+    {
+        _o.sock_state_cb      = cb;
+        _o.sock_state_cb_data = data;
+        set_bit_if(cb, ARES_OPT_SOCK_STATE_CB);
+    }
+
 
 //     ARES_OPT_SERVERS struct in_addr *servers;
 //                             int nservers;
@@ -105,7 +138,7 @@ public:
 class ares_ch
 {
     struct ch_deleter { void operator()(ares_channel ch) noexcept { ::ares_destroy(ch); } };
-    std::unique_ptr<ares_channel, ch_deleter> _ch;
+    std::unique_ptr<std::remove_pointer_t<ares_channel>, ch_deleter> _ch;
 
     ares_ch(ares_channel h) : _ch(h) {}
 
@@ -117,7 +150,7 @@ public:
         _ch.reset(ch);
     }
 
-    explicit ares_ch(ares_opts& opts)
+    explicit ares_ch(ares_opts opts)
     {
         ares_channel ch = nullptr;
         throw_ares_error_on_failure(::ares_init_options(&ch, opts.handle(), opts.mask()));
@@ -139,7 +172,7 @@ public:
     ares_ch dup()
     {
         ares_channel h = nullptr;
-        throw_ares_error_on_failure(::ares_dup(h, handle()));
+        throw_ares_error_on_failure(::ares_dup(&h, handle()));
         return {h};
     }
 
@@ -177,6 +210,14 @@ public:
         }
     }
 
+    // servers: comma separated list of "host[:port]", e.g.: "1.1.1.1,8.8.8.8:53,[2001:4860:4860::8888]:53".
+    // a lookup goes to the next server when one fails or times out.
+    template<class Str>
+    void set_servers(Str const& servers)
+    {
+        throw_ares_error_on_failure(::ares_set_servers_ports_csv(handle(), as_cstr(servers).data()));
+    }
+
     template<class Str>
     void set_local_dev(Str const& name)
     {
@@ -186,156 +227,326 @@ public:
 
 
 
-class ares_resolver
+template<class Endpoint>
+struct ares_results
 {
-    using TIME_S = boost::posix_time::seconds;
+    std::vector<Endpoint> endpoints;
+    std::chrono::seconds  ttl{0}; // min ttl of all records, including cnames
+
+    auto begin() const noexcept { return endpoints.begin(); }
+    auto end  () const noexcept { return endpoints.end  (); }
+    size_t size() const noexcept { return endpoints.size(); }
+    bool  empty() const noexcept { return endpoints.empty(); }
+};
+
 
+// resolves with ares_getaddrinfo(), c-ares sockets are waited on the io_context(like curl_client does for curl),
+// and c-ares timeouts are driven by a steady_timer, so any number of lookups run on a single thread.
+// all channel operations run on a strand, so the io_context may be run by multiple threads.
+// typical usage:
+//    ares_resolver rsv(ioc);
+//    JKL_CO_TRY(eps, co_await rsv.resolve("example.com", "443"));
+//    // or co_await conn.connect_with(rsv, url);
+template<class Protocol = asio::ip::tcp>
+class ares_resolver_t
+{
 public:
-    explicit ares_resolver(asio::io_context& ioc = default_ioc())
-        : io_context_(ioc), channel_(), timer_(io)
+    using protocol_type = Protocol;
+    using endpoint_type = typename Protocol::endpoint;
+    using results_type  = ares_results<endpoint_type>;
+    using executor_type = asio::strand<asio::io_context::executor_type>;
+
+private:
+    // a single lookup, also the async object for ec_awaiter, so stop/timeout only abandons this lookup.
+    // created before the lookup starts, the handler is handed over under the lock,
+    // so a cancel() from any thread either aborts the handler or marks the op cancelled before it's set.
+    class query_op
     {
-        //printf("new channel\n");
-        ares_options opts;
-        opts.timeout = DNS_TIMEOUT;
-        opts.tries = MAX_TRIES;
-        ::ares_init_options(&channel_, &opts, ARES_OPT_TIMEOUT | ARES_OPT_TRIES);
+        std::mutex _mtx;
+        std::function<void(aerror_code const&, results_type)> _h;
+        bool _cancelled = false;
+        executor_type _ex;
 
+    public:
+        explicit query_op(executor_type const& ex) : _ex{ex} {}
 
-        ares_addr_node node;
-        node.next = nullptr;
-        node.family = AF_INET;
-        node.addr.addr4.s_addr = inet_addr("114.114.114.114");
+        auto get_executor() const { return _ex; }
 
-        ::ares_set_servers(channel_, &node);
-    }
+        template<class H>
+        void set_handler(H&& h)
+        {
+            {
+                std::lock_guard lg{_mtx};
 
+                if(! _cancelled)
+                {
+                    _h = std::forward<H>(h);
+                    return;
+                }
+            }
 
-    ~channel()
-    {
-        ares_destroy(channel_);
-        printf("channel die\n");
-    }
+            h(asio::error::operation_aborted, results_type{});
+        }
+
+        bool cancelled()
+        {
+            std::lock_guard lg{_mtx};
+            return _cancelled;
+        }
+
+        void complete(aerror_code const& ec, results_type r)
+        {
+            decltype(_h) h;
+            {
+                std::lock_guard lg{_mtx};
+                h = std::move(_h);
+            }
+            if(h)
+                h(ec, std::move(r));
+        }
+
+        void cancel()
+        {
+            {
+                std::lock_guard lg{_mtx};
+                _cancelled = true;
+            }
+
+            complete(asio::error::operation_aborted, {});
+        }
+    };
 
-    ares_channel& get_channel_()
+    struct socket_data
     {
-        return channel_;
-    }
+        asio::posix::stream_descriptor sd;
+        bool   read    = false; // c-ares wants read
+        bool   write   = false; // c-ares wants write
+        bool   reading = false; // waiting for readable
+        bool   writing = false; // waiting for writable
+        size_t id      = 0;
+
+        explicit socket_data(executor_type const& ex) : sd{ex} {}
+
+        ~socket_data()
+        {
+            if(sd.is_open())
+                sd.release(); // c-ares closes it
+        }
+
+        socket_data(socket_data&&) = default;
+        socket_data& operator=(socket_data&&) = default;
+    };
+
+    executor_type      _strand;
+    asio::steady_timer _timer;
+    unordered_node_map<ares_socket_t, socket_data> _sds;
+    size_t _idSeq = 0;
+    ares_ch _ch; // destroyed first, as it may call back into above members
 
-    void FinishResolve()
+    static ares_opts make_opts(ares_opts opts, ares_resolver_t* self)
     {
-        timer_.cancel();
+        opts.set_sock_state_cb(&sock_state_cb, self);
+        return opts;
     }
 
-    template<class CALLBACK>
-    static void query_callback_wrapper(void* args, int status, int timeouts, unsigned char* abuf, int alen)
+    // on strand
+    static void sock_state_cb(void* data, ares_socket_t fd, int readable, int writable)
     {
-        std::unique_ptr<CALLBACK> callback(static_cast<CALLBACK*>(args));
-        (*callback)(status, timeouts, abuf, alen);
-    }
+        auto& self = *static_cast<ares_resolver_t*>(data);
 
+        if(! readable && ! writable)
+        {
+            self._sds.erase(fd);
+            return;
+        }
 
+        auto it = self._sds.find(fd);
 
-    template<class CALLBACK>
-    void query(const std::string &domain, int dnsclass, int type, const CALLBACK &callback)
-    {
-        auto arg = new CALLBACK(std::move(callback));
+        if(it == self._sds.end())
+        {
+            socket_data d{self._strand};
 
-        ares_query(channel_, domain.c_str(), dnsclass, type, &query_callback_wrapper<CALLBACK>, arg);
+            aerror_code ec;
+            d.sd.assign(fd, ec);
+            if(ec)
+                return; // c-ares will time out the query
 
-        this->timer_.expires_from_now(TIME_S(2 * DNS_TIMEOUT));
-        this->timer_.async_wait(boost::bind(&channel::handlerOnTimeUp<CALLBACK>,this->shared_from_this(),boost::asio::placeholders::error, arg));
+            d.id = ++ self._idSeq;
+            it = self._sds.try_emplace(fd, std::move(d)).first;
+        }
 
-        getsock();
+        it->second.read  = readable;
+        it->second.write = writable;
+        self.wait_socket(fd, it->second);
     }
 
-    void getsock()
+    // on strand
+    void wait_socket(ares_socket_t fd, socket_data& d)
     {
-        boost::array<ares_socket_t, ARES_GETSOCK_MAXNUM> sockets_ = {{0}};
-        int bitmask = ::ares_getsock(channel_, sockets_.data(), sockets_.size());
-        for (int i = 0; i < ARES_GETSOCK_MAXNUM; ++i)
+        if(d.read && ! d.reading)
         {
-            if (ARES_GETSOCK_READABLE(bitmask, i))
-            {
-
-                boost::asio::posix::stream_descriptor descriptor(io_context_);
-                auto result = stream_descriptors_.emplace(sockets_[i], std::move(descriptor));
-                if (result.second)
-                {
-                    assert(!result.first->second.is_open());
-                    result.first->second.assign(sockets_[i]);
-                }
-                assert(result.first->second.is_open());
-                if (ARES_GETSOCK_READABLE(bitmask, i))
-                {
-                    result.first->second.async_read_some(boost::asio::null_buffers(),
-                        boost::bind(&channel::read_handler, shared_from_this(),
-                            boost::asio::placeholders::error,
-                            boost::asio::placeholders::bytes_transferred,
-                            sockets_[i]));
-                    //printf("ARES_GETSOCK_READABLE %d\n", sockets_[i]);
-
-                }
-
+            d.reading = true;
+            d.sd.async_wait(asio::posix::descriptor_base::wait_read,
+                asio::bind_executor(_strand, [this, fd, id = d.id](aerror_code const& ec){ on_socket_event(fd, id, ec, true); }));
+        }
 
-                return;
-            }
+        if(d.write && ! d.writing)
+        {
+            d.writing = true;
+            d.sd.async_wait(asio::posix::descriptor_base::wait_write,
+                asio::bind_executor(_strand, [this, fd, id = d.id](aerror_code const& ec){ on_socket_event(fd, id, ec, false); }));
         }
     }
 
+    // on strand
+    void on_socket_event(ares_socket_t fd, size_t id, aerror_code const& ec, bool read)
+    {
+        if(ec == asio::error::operation_aborted)
+            return;
 
+        // fd may have been closed by c-ares and reused
+        auto it = _sds.find(fd);
+        if(it == _sds.end() || it->second.id != id)
+            return;
 
+        (read ? it->second.reading : it->second.writing) = false;
 
-private:
+        // on error, let c-ares find it out by reading/writing
+        ::ares_process_fd(_ch.handle(), read ? fd : ARES_SOCKET_BAD, read ? ARES_SOCKET_BAD : fd);
 
-    boost::asio::io_context &io_context_;
-    boost::asio::deadline_timer timer_;
-    unsigned int tries_ = 0;
-    ares_channel channel_;
+        it = _sds.find(fd);
+        if(it != _sds.end() && it->second.id == id)
+            wait_socket(fd, it->second);
 
-    typedef std::map<int, boost::asio::posix::stream_descriptor> stream_descriptors_type;
-    stream_descriptors_type stream_descriptors_;
+        update_timer();
+    }
 
-    template<class CALLBACK>
-    void handlerOnTimeUp(const boost::system::error_code &ec, CALLBACK* callback)
+    // on strand
+    void update_timer()
     {
-        if(ec)
+        timeval tv;
+
+        if(! ::ares_timeout(_ch.handle(), nullptr, &tv))
         {
-            //printf("handlerOnTimeUp err -> %s \n",ec.message().c_str());
-            stream_descriptors_.begin()->second.cancel();
+            _timer.cancel();
             return;
         }
-        //printf("timeup\n");
-        if(tries_ == MAX_TRIES + 1)
+
+        _timer.expires_after(std::chrono::seconds(tv.tv_sec) + std::chrono::microseconds(tv.tv_usec));
+        _timer.async_wait(asio::bind_executor(_strand, [this](aerror_code const& ec){
+            if(ec)
+                return;
+            ::ares_process_fd(_ch.handle(), ARES_SOCKET_BAD, ARES_SOCKET_BAD);
+            update_timer();
+        }));
+    }
+
+    static void on_addrinfo(void* arg, int status, int /*timeouts*/, ares_addrinfo* ai)
+    {
+        std::unique_ptr<std::shared_ptr<query_op>> op(static_cast<std::shared_ptr<query_op>*>(arg));
+        std::unique_ptr<ares_addrinfo, decltype(&::ares_freeaddrinfo)> aip(ai, &::ares_freeaddrinfo);
+
+        if(status != ARES_SUCCESS)
         {
-            //printf("max tries\n");
-            stream_descriptors_.begin()->second.cancel();
+            (*op)->complete(make_ares_error(status), {});
             return;
         }
 
-        ++tries_;
-        ::ares_process_fd(channel_, ARES_SOCKET_BAD, ARES_SOCKET_BAD);
+        results_type r;
+        int ttl = INT_MAX;
 
-        this->timer_.expires_from_now(TIME_S(2 * DNS_TIMEOUT));
-        this->timer_.async_wait(boost::bind(&channel::handlerOnTimeUp<CALLBACK>,this->shared_from_this(),boost::asio::placeholders::error, callback));
+        for(auto* c = ai->cnames; c; c = c->next)
+            ttl = (std::min)(ttl, c->ttl);
 
+        for(auto* n = ai->nodes; n; n = n->ai_next)
+        {
+            endpoint_type ep;
+
+            if(n->ai_addrlen > ep.capacity())
+                continue;
 
+            std::memcpy(ep.data(), n->ai_addr, n->ai_addrlen);
+            ep.resize(n->ai_addrlen);
+            r.endpoints.emplace_back(ep);
+
+            ttl = (std::min)(ttl, n->ai_ttl);
+        }
+
+        r.ttl = std::chrono::seconds(ttl == INT_MAX ? 0 : (std::max)(ttl, 0));
+
+        (*op)->complete({}, std::move(r));
     }
 
-    void read_handler(const boost::system::error_code & ec, std::size_t size,
-        ares_socket_t fd)
+public:
+    explicit ares_resolver_t(asio::io_context& ioc = default_ioc(), ares_opts opts = {})
+        : _strand{ioc.get_executor()}, _timer{ioc}, _ch{make_opts(opts, this)}
+    {}
+
+    ares_resolver_t(ares_resolver_t const&) = delete;
+    ares_resolver_t& operator=(ares_resolver_t const&) = delete;
+
+    // NOTE: destroying the resolver completes pending lookups with ARES_EDESTRUCTION,
+    //       it must be destroyed on the strand or when the io_context is not running.
+
+    executor_type get_executor() const noexcept { return _strand; }
+    ares_ch& channel() noexcept { return _ch; }
+
+    // should be called before any lookup, see ares_ch::set_servers().
+    // ares_opts::set_tries()/set_timeout_ms() control how soon a lookup fails over to next server.
+    template<class Str>
+    void set_servers(Str const& servers) { _ch.set_servers(servers); }
+
+    // cancels all pending lookups with ARES_ECANCELLED
+    void cancel()
     {
-        if(ec)
-        {
-            //printf("read_handler err -> %s \n",ec.message().c_str());
-            return;
-        }
+        asio::dispatch(_strand, [this](){ _ch.cancel(); });
+    }
+
+    // service: port number or service name, may be empty.
+    // p: params for make_ec_awaiter, each lookup can be stopped or expire individually.
+    template<class Host, class Service, class... P>
+        requires(_str_<Service> || _arithmetic_<Service>) // otherwise resolve(host, p...) below
+    aresult_task<results_type> resolve(Host const& host, Service const& service, P... p)
+    {
+        auto op = std::make_shared<query_op>(_strand);
 
-        //printf("read_handler\n");
+        auto&& svc = stringify(service);
+        string hostStr(str_data(host), str_size(host));
+        string svcStr (str_data(svc ), str_size(svc ));
 
-        ::ares_process_fd(channel_, fd, ARES_SOCKET_BAD);
+        co_return co_await make_ec_awaiter<results_type>(*op,
+            [&](auto&& h)
+            {
+                op->set_handler(std::move(h));
 
+                asio::dispatch(_strand, [this, op, host = hostStr, service = svcStr]() mutable
+                {
+                    if(op->cancelled())
+                        return;
+
+                    ares_addrinfo_hints hints{};
+                    hints.ai_flags    = ARES_AI_NOSORT; // will be raced by happy_eyeballs_connect() anyway
+                    hints.ai_family   = AF_UNSPEC;
+                    hints.ai_socktype = protocol_type::v4().type();
+                    hints.ai_protocol = protocol_type::v4().protocol();
+
+                    ::ares_getaddrinfo(_ch.handle(), host.c_str(), service.size() ? service.c_str() : nullptr,
+                                       &hints, &on_addrinfo, new std::shared_ptr<query_op>(std::move(op)));
+                    update_timer();
+                });
+            },
+            p...);
     }
 
+    // a coroutine too, so the empty service outlives the lookup
+    template<class Host, class... P>
+    aresult_task<results_type> resolve(Host const& host, P... p)
+    {
+        co_return co_await resolve(host, std::string_view(), p...);
+    }
 };
 
-} // namespace jkl
\ No newline at end of file
+using ares_resolver = ares_resolver_t<>;
+
+
+} // namespace jkl
@@ -0,0 +1,412 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <jkl/buf.hpp>
+#include <jkl/file.hpp>
+#include <jkl/task.hpp>
+#include <jkl/result.hpp>
+#include <jkl/ec_awaiter.hpp>
+#include <jkl/util/str.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/executor.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/thread_pool.hpp>
+#if defined(BOOST_ASIO_HAS_FILE)
+#   include <boost/asio/basic_random_access_file.hpp>
+#   include <boost/asio/cancellation_signal.hpp>
+#   include <boost/asio/bind_cancellation_slot.hpp>
+#else
+#   include <cerrno>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/stat.h>
+#endif
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+
+namespace jkl{
+
+
+// runs blocking file I/O for async_file when asio has no asynchronous file support
+inline asio::thread_pool& default_blocking_io_pool()
+{
+    static asio::thread_pool p(4);
+    return p;
+}
+
+
+// random access file with positional asynchronous I/O.
+// read_at()/write_at() don't share a file cursor, so any number of them can be in flight on the same file,
+// e.g.: to keep NVMe queues busy.
+// uses asio::basic_random_access_file when asio supports files(io_uring on linux, see ioc.hpp, IOCP on windows),
+// otherwise pread()/pwrite() on a blocking I/O thread pool, completions are delivered to the file's executor either way.
+// typical usage:
+//    async_file f(ioc.get_executor());
+//    JKL_CO_TRY(f.open("dump.bin", file_mode::read));
+//    JKL_CO_TRY(n, co_await f.read_at(offset, buf));
+// NOTE: all operations must be completed before closing or destroying the file.
+// NOTE: on the thread pool, cancellation(p_enable_stop, p_expires_after) completes the awaiter immediately,
+//       but can't stop a pread()/pwrite() already running, so the buffer must outlive it.
+template<class Executor = asio::executor>
+class async_file_t
+{
+public:
+    using executor_type = Executor;
+
+private:
+#if defined(BOOST_ASIO_HAS_FILE)
+    using file_type = asio::basic_random_access_file<Executor>;
+
+    file_type _f;
+
+    static typename file_type::flags to_flags(file_mode mode) noexcept
+    {
+        switch(mode)
+        {
+            case file_mode::read:
+            case file_mode::scan:           return file_type::read_only;
+            case file_mode::write:          return file_type::read_write | file_type::create | file_type::truncate;
+            case file_mode::write_new:      return file_type::read_write | file_type::create | file_type::exclusive;
+            case file_mode::write_existing: return file_type::read_write;
+            case file_mode::append:         return file_type::write_only | file_type::create | file_type::append;
+            case file_mode::append_existing:return file_type::write_only | file_type::append;
+        }
+        return file_type::read_only;
+    }
+
+    // a single operation, also the async object for ec_awaiter, so stop/timeout only cancels this operation
+    struct file_op
+    {
+        executor_type ex;
+        asio::cancellation_signal sig;
+
+        auto get_executor() const { return ex; }
+        void cancel() { sig.emit(asio::cancellation_type::all); }
+    };
+#else
+    Executor           _ex;
+    asio::thread_pool* _pool;
+    int                _fd = -1;
+    // bumped by cancel(), completions of earlier operations are reported as operation_aborted
+    std::shared_ptr<std::atomic<uint64_t>> _gen = std::make_shared<std::atomic<uint64_t>>(0);
+
+    // a single operation, also the async object for ec_awaiter, so stop/timeout only aborts this operation
+    struct pool_op
+    {
+        executor_type ex;
+        std::shared_ptr<std::atomic_bool> aborted = std::make_shared<std::atomic_bool>(false);
+
+        auto get_executor() const { return ex; }
+        void cancel() noexcept { aborted->store(true, std::memory_order_relaxed); }
+    };
+
+    static int to_flags(file_mode mode) noexcept
+    {
+        switch(mode)
+        {
+            case file_mode::read:
+            case file_mode::scan:           return O_RDONLY;
+            case file_mode::write:          return O_RDWR | O_CREAT | O_TRUNC;
+            case file_mode::write_new:      return O_RDWR | O_CREAT | O_EXCL;
+            case file_mode::write_existing: return O_RDWR;
+            case file_mode::append:         return O_WRONLY | O_CREAT | O_APPEND;
+            case file_mode::append_existing:return O_WRONLY | O_APPEND;
+        }
+        return O_RDONLY;
+    }
+
+    // runs op() on the pool, unless aborted before it starts, then h(ec, n) on the executor.
+    // the work guard keeps the executor's context running while op() is on the pool, like any pending async op.
+    void post_op(std::shared_ptr<std::atomic_bool> aborted, auto&& op, auto&& h, bool eofOnZero = false)
+    {
+        asio::post(*_pool,
+            [work = asio::make_work_guard(_ex), ex = _ex, gen = _gen, g = _gen->load(std::memory_order_relaxed), aborted = std::move(aborted), eofOnZero,
+             op = JKL_FORWARD(op), h = JKL_FORWARD(h)]() mutable
+            {
+                aerror_code ec;
+                size_t n = 0;
+
+                while(! aborted->load(std::memory_order_relaxed))
+                {
+                    ssize_t r = op();
+
+                    if(r >= 0)
+                    {
+                        n = static_cast<size_t>(r);
+                        break;
+                    }
+
+                    if(errno != EINTR)
+                    {
+                        ec.assign(errno, asio::error::get_system_category());
+                        break;
+                    }
+                }
+
+                if(! ec && n == 0 && eofOnZero)
+                    ec = asio::error::eof;
+
+                asio::post(ex,
+                    [gen = std::move(gen), g, aborted = std::move(aborted), ec, n, h = std::move(h)]() mutable
+                    {
+                        if(gen->load(std::memory_order_relaxed) != g || aborted->load(std::memory_order_relaxed))
+                            ec = asio::error::operation_aborted;
+                        h(ec, n);
+                    });
+            });
+    }
+#endif
+
+public:
+#if defined(BOOST_ASIO_HAS_FILE)
+    explicit async_file_t(Executor const& ex) : _f{ex} {}
+
+    template<class ExC>
+    explicit async_file_t(ExC& ctx) : _f{ctx} {}
+#else
+    // pool: runs the blocking I/O, must outlive the file
+    explicit async_file_t(Executor const& ex, asio::thread_pool& pool = default_blocking_io_pool())
+        : _ex{ex}, _pool{&pool}
+    {}
+
+    template<class ExC>
+    explicit async_file_t(ExC& ctx, asio::thread_pool& pool = default_blocking_io_pool())
+        : _ex{ctx.get_executor()}, _pool{&pool}
+    {}
+
+    async_file_t(async_file_t&& r) noexcept
+        : _ex{r._ex}, _pool{r._pool}, _fd{std::exchange(r._fd, -1)}, _gen{std::move(r._gen)}
+    {
+        r._gen = std::make_shared<std::atomic<uint64_t>>(0);
+    }
+
+    async_file_t& operator=(async_file_t&& r) noexcept
+    {
+        if(this != &r)
+        {
+            (void)close();
+            _ex   = r._ex;
+            _pool = r._pool;
+            _fd   = std::exchange(r._fd, -1);
+            std::swap(_gen, r._gen);
+        }
+        return *this;
+    }
+
+    ~async_file_t()
+    {
+        (void)close();
+    }
+#endif
+
+#if defined(BOOST_ASIO_HAS_FILE)
+    executor_type get_executor() noexcept { return _f.get_executor(); }
+
+    bool is_open() const noexcept { return _f.is_open(); }
+    auto native_handle() { return _f.native_handle(); }
+
+    _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+    aresult<> open(_char_str_ auto const& path, file_mode mode)
+    {
+        aerror_code ec;
+        _f.open(as_cstr(path).data(), to_flags(mode), ec);
+        return ec;
+    }
+
+    aresult<> close()
+    {
+        aerror_code ec;
+        _f.close(ec);
+        return ec;
+    }
+
+    aresult<uint64_t> size() const
+    {
+        aerror_code ec;
+        auto n = _f.size(ec);
+        if(! ec)
+            return n;
+        return ec;
+    }
+
+    aresult<> resize(uint64_t n)
+    {
+        aerror_code ec;
+        _f.resize(n, ec);
+        return ec;
+    }
+
+    // cancels all operations in flight
+    void cancel()
+    {
+        aerror_code ec;
+        _f.cancel(ec);
+    }
+
+    // reads at most b.size() bytes at offset, returns bytes read, or asio::error::eof at end of file.
+    template<class... P>
+    aresult_task<size_t> read_some_at(uint64_t offset, asio::mutable_buffer b, P... p)
+    {
+        file_op op{get_executor()};
+
+        co_return co_await make_ec_awaiter<size_t>(op,
+            [&, offset, b](auto&& h){ _f.async_read_some_at(offset, b, asio::bind_cancellation_slot(op.sig.slot(), std::move(h))); },
+            p...);
+    }
+
+    template<class... P>
+    aresult_task<size_t> write_some_at(uint64_t offset, asio::const_buffer b, P... p)
+    {
+        file_op op{get_executor()};
+
+        co_return co_await make_ec_awaiter<size_t>(op,
+            [&, offset, b](auto&& h){ _f.async_write_some_at(offset, b, asio::bind_cancellation_slot(op.sig.slot(), std::move(h))); },
+            p...);
+    }
+#else
+    executor_type get_executor() const noexcept { return _ex; }
+
+    bool is_open() const noexcept { return _fd != -1; }
+    int native_handle() const noexcept { return _fd; }
+
+    _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+    aresult<> open(_char_str_ auto const& path, file_mode mode)
+    {
+        JKL_TRY(close());
+
+        int fd = ::open(as_cstr(path).data(), to_flags(mode) | O_CLOEXEC, 0644);
+        if(fd == -1)
+            return aerror_code(errno, asio::error::get_system_category());
+
+        _fd = fd;
+        return no_err;
+    }
+
+    aresult<> close()
+    {
+        if(_fd != -1 && ::close(std::exchange(_fd, -1)) == -1)
+            return aerror_code(errno, asio::error::get_system_category());
+        return no_err;
+    }
+
+    aresult<uint64_t> size() const
+    {
+        struct stat st;
+        if(::fstat(_fd, &st) == -1)
+            return aerror_code(errno, asio::error::get_system_category());
+        return static_cast<uint64_t>(st.st_size);
+    }
+
+    aresult<> resize(uint64_t n)
+    {
+        if(::ftruncate(_fd, static_cast<off_t>(n)) == -1)
+            return aerror_code(errno, asio::error::get_system_category());
+        return no_err;
+    }
+
+    // cancels all operations in flight
+    void cancel() noexcept
+    {
+        _gen->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // reads at most b.size() bytes at offset, returns bytes read, or asio::error::eof at end of file.
+    template<class... P>
+    aresult_task<size_t> read_some_at(uint64_t offset, asio::mutable_buffer b, P... p)
+    {
+        pool_op op{_ex};
+
+        co_return co_await make_ec_awaiter<size_t>(op,
+            [&, offset, b](auto&& h)
+            {
+                post_op(op.aborted,
+                        [fd = _fd, offset, b](){ return ::pread(fd, b.data(), b.size(), static_cast<off_t>(offset)); },
+                        std::move(h), b.size() > 0);
+            },
+            p...);
+    }
+
+    template<class... P>
+    aresult_task<size_t> write_some_at(uint64_t offset, asio::const_buffer b, P... p)
+    {
+        pool_op op{_ex};
+
+        co_return co_await make_ec_awaiter<size_t>(op,
+            [&, offset, b](auto&& h)
+            {
+                post_op(op.aborted,
+                        [fd = _fd, offset, b](){ return ::pwrite(fd, b.data(), b.size(), static_cast<off_t>(offset)); },
+                        std::move(h));
+            },
+            p...);
+    }
+#endif
+
+    _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+    auto read_some_at(uint64_t offset, _byte_buf_ auto& b, auto... p)
+    {
+        return read_some_at(offset, asio::mutable_buffer(asio_buf(b)), p...);
+    }
+
+    _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+    auto write_some_at(uint64_t offset, _byte_buf_ auto const& b, auto... p)
+    {
+        return write_some_at(offset, asio::const_buffer(buf_data(b), buf_size(b)), p...);
+    }
+
+    // fills b from offset, returns bytes read, which is less than buf_size(b) only at end of file.
+    // resizable b(e.g.: string, vector) is resized to bytes read.
+    template<_byte_buf_ B, class... P>
+    aresult_task<size_t> read_at(uint64_t offset, B& b, P... p)
+    {
+        size_t const size = buf_size(b);
+        size_t n = 0;
+
+        while(n < size)
+        {
+            auto r = co_await read_some_at(offset + n, asio::mutable_buffer(buf_data(b) + n, size - n), p...);
+
+            if(! r)
+            {
+                if(r.error() == asio::error::eof)
+                    break;
+                co_return r.error();
+            }
+
+            if(*r == 0)
+                break;
+
+            n += *r;
+        }
+
+        if constexpr(_resizable_buf_<B>)
+            resize_buf(b, n);
+
+        co_return n;
+    }
+
+    // writes all of b at offset
+    template<_byte_buf_ B, class... P>
+    aresult_task<size_t> write_at(uint64_t offset, B const& b, P... p)
+    {
+        size_t const size = buf_size(b);
+        size_t n = 0;
+
+        while(n < size)
+        {
+            JKL_CO_TRY(size_t w, co_await write_some_at(offset + n, asio::const_buffer(buf_data(b) + n, size - n), p...));
+            n += w;
+        }
+
+        co_return n;
+    }
+};
+
+using async_file = async_file_t<>;
+
+
+} // namespace jkl
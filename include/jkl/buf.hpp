@@ -3,6 +3,7 @@
 #include <jkl/config.hpp>
 #include <jkl/util/buf.hpp>
 #include <boost/asio/buffer.hpp>
+#include <array>
 
 
 namespace jkl{
@@ -32,6 +33,15 @@ auto buy_asio_buf(_resizable_buf_ auto& b, size_t n) noexcept
 }
 
 
+// gathers byte bufs into a const buffer sequence without copying, e.g.: for a single writev.
+// the bufs must outlive the returned sequence.
+_JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+auto gather_bufs(_byte_buf_ auto const&... b) noexcept
+{
+    return std::array<asio::const_buffer, sizeof...(b)>{asio::buffer(buf_data(b), buf_size(b))...};
+}
+
+
 // a buffer wrapper that satisfies asio DynamicBuffer_v1 and DynamicBuffer_v2
 template<_resizable_byte_buf_ Buf>
 class dynabuf
@@ -7,6 +7,8 @@
 #include <jkl/params.hpp>
 #include <jkl/res_pool.hpp>
 #include <jkl/http_msg.hpp>
+#include <jkl/util/unit.hpp>
+#include <jkl/util/unordered_map_set.hpp>
 #include <jkl/curl/easy.hpp>
 #include <jkl/curl/multi.hpp>
 #include <boost/asio/ip/tcp.hpp>
@@ -16,6 +18,7 @@
 #include <boost/beast/http/string_body.hpp>
 #include <boost/beast/core/flat_buffer.hpp>
 #include <atomic>
+#include <cctype>
 #include <memory>
 #include <optional>
 
@@ -78,6 +81,16 @@ public:
 
     auto* data() noexcept { return buf_data(_b); }
 
+    // pre-allocate for n more bytes, only meaningful when whole data is appended to a resizable buf
+    void reserve_more(size_t n)
+    {
+        if constexpr(! ReadSome && is_resizable_buf)
+        {
+            if constexpr(requires{ _b.reserve(n); })
+                _b.reserve(buf_size(_b) + n);
+        }
+    }
+
     size_t size() const noexcept
     {
         if constexpr(ReadSome || ! is_resizable_buf)
@@ -231,6 +244,9 @@ public:
         pause_type _pauseType = pause_type_none;
         size_t _writeCbDataUsed = 0;
 
+        string _body;        // recycled body buffer, see read_body_buf()
+        size_t _hostKey = 0; // authority_key() of current target
+
         aerror_code& awaiter_ec() { BOOST_ASSERT(_aw); return _aw->_ec; };
         std::coroutine_handle<> awaiter_coro() const { BOOST_ASSERT(_aw); return _aw->_coro; };
 
@@ -318,6 +334,7 @@ public:
 
             _pauseType = pause_type_none;
             _writeCbDataUsed = 0;
+            _hostKey = 0;
             set_state(state_reseted);
 
             _cl.apply_default_opts(*this);
@@ -332,9 +349,46 @@ public:
                 set_state(state_finished);
             }
 
+            // keep the capacity for next use, unless it grows too large
+            clear_buf(_body);
+            if(_body.capacity() > _cl.body_buf_high_water())
+                string().swap(_body);
+
             reset_all();
         }
 
+        // expected size of the body being received:
+        // Content-Length if known, otherwise the moving average of previous bodies from same host.
+        // 0 if the average can't be read, locking its mutex may throw.
+        size_t body_size_hint() noexcept
+        {
+            curl_off_t n = -1;
+
+            if(curl_easy_getinfo(_easy.handle(), CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &n) == CURLE_OK && n > 0)
+                return std::min(static_cast<size_t>(n), _cl.body_buf_high_water());
+
+            try
+            {
+                return _cl.body_size_avg(_hostKey);
+            }
+            catch(...)
+            {
+                return 0;
+            }
+        }
+
+        _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+        void presize_body(_resizable_byte_buf_ auto& b)
+        {
+            if constexpr(requires{ b.reserve(size_t()); })
+                b.reserve(buf_size(b) + _cl.body_size_avg(_hostKey));
+        }
+
+        void record_body_size(size_t n)
+        {
+            _cl.update_body_size_avg(_hostKey, n);
+        }
+
         enum read_type
         {
             // NOTE: hd here means bytes passed to CURLOPT_HEADERFUNCTION, for http protocol, it's header and trailer
@@ -360,6 +414,8 @@ public:
             JKL_DEF_MEMBER_IF(EnableStop, optional_stop_callback<>, _stopCb       );
             JKL_DEF_MEMBER_IF(EnableStop, bool                    , _stopRequested) = false;
 
+            bool _bodyReserved = false;
+
             constexpr bool exam_stop()
             {
                 if constexpr(EnableStop)
@@ -404,6 +460,13 @@ public:
                 if(prevUsed > n) // something wrong
                     return 0;
 
+                if constexpr(PauseType == pause_type_wd && ! (ReadSomeBits & Bw))
+                {
+                    // size the buf once for the whole body, instead of growing it on each call
+                    if(! std::exchange(w->_bodyReserved, true))
+                        w->get_bw<Bw>().reserve_more(w->_cr.body_size_hint());
+                }
+
                 if constexpr(ReadSomeBits & Bw)
                 {
                     size_t m = n - prevUsed;
@@ -842,7 +905,11 @@ public:
 
         // can be string or curlu
         _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
-        auto& target(auto const& u) { return opts(curlopt::url(u)); }
+        auto& target(auto const& u)
+        {
+            _hostKey = authority_key(u);
+            return opts(curlopt::url(u));
+        }
 
         _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
         auto& field_line(auto&&... lines) // string or curlist
@@ -947,14 +1014,47 @@ public:
             co_return h;
         }
 
+        // when B is string, the body is read into the recycled buffer, whose capacity is handed to the caller,
+        // and the recycled buffer is reserved again for next use.
         template<_resizable_byte_buf_ B = string>
         aresult_task<B> return_body(auto... p)
         {
             B b;
+
+            if constexpr(std::is_same_v<B, string>)
+            {
+                b = std::move(_body);
+                clear_buf(b);
+            }
+
+            presize_body(b);
             JKL_CO_TRY(co_await read_body(b, p...));
+            record_body_size(buf_size(b));
+
+            if constexpr(std::is_same_v<B, string>)
+            {
+                clear_buf(_body);
+                presize_body(_body);
+            }
+
             co_return b;
         }
 
+        // read whole body into the buffer recycled with this request,
+        // so no allocation is needed once its capacity has warmed up.
+        // the returned view is valid until next read_body_buf() or this request is recycled.
+        _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+        aresult_task<string_view> read_body_buf(auto... p)
+        {
+            clear_buf(_body);
+            presize_body(_body);
+            JKL_CO_TRY(co_await read_body(_body, p...));
+            record_body_size(buf_size(_body));
+            co_return string_view(_body);
+        }
+
+        string& body_buf() noexcept { return _body; }
+
         template<class Fields = http_fields>
         aresult_task<Fields> return_trailer(auto... p)
         {
@@ -1142,6 +1242,110 @@ private:
     string _defaultProxy;
     std::deque<string> _noProxyList;
 
+    static constexpr size_t max_body_size_avg_entries = 65536;
+
+    std::atomic_size_t _bodyBufHighWater = MiB<size_t>(1).count();
+    std::mutex _bodySizeMtx; // NOTE: may be locked inside _mtx, never the reverse.
+    unordered_flat_map<size_t, size_t> _bodySizeAvg; // authority_key -> moving average of body size
+
+    // identifies the authority of an url by its lower cased scheme, host and port(defaulted by scheme),
+    // so "HTTP://a.com/x", "http://user@a.com:80/" and curlu of them share a key.
+    // only used for size hints, so hash collision is harmless.
+    static size_t authority_key(string_view scheme, string_view host, string_view port) noexcept
+    {
+        char   k[320]; // longer ones are truncated
+        size_t n = 0;
+
+        auto append = [&](string_view s)
+        {
+            for(char c : s.substr(0, (std::min)(s.size(), sizeof(k) - n)))
+                k[n++] = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        };
+
+        append(scheme.empty() ? string_view("http") : scheme); // as curl assumes
+        string_view const lowScheme(k, n);
+
+        if(port.empty())
+        {
+            if(lowScheme == "https" || lowScheme == "wss")
+                port = "443";
+            else if(lowScheme == "http" || lowScheme == "ws")
+                port = "80";
+        }
+
+        append("://");
+        append(host);
+        append(":");
+        append(port);
+
+        return robin_hood::hash_bytes(k, n);
+    }
+
+    _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+    static size_t authority_key(_str_ auto const& u) noexcept
+    {
+        string_view s{str_data(u), str_size(u)};
+        string_view scheme, port;
+
+        if(auto p = s.find("://"); p != npos)
+        {
+            scheme = s.substr(0, p);
+            s.remove_prefix(p + 3);
+        }
+
+        s = s.substr(0, s.find_first_of("/?#"));
+
+        if(auto p = s.rfind('@'); p != npos) // user info
+            s.remove_prefix(p + 1);
+
+        if(auto p = s.rfind(':'); p != npos && s.find(']', p) == npos) // not inside [ipv6]
+        {
+            port = s.substr(p + 1);
+            s    = s.substr(0, p);
+        }
+
+        return authority_key(scheme, s, port);
+    }
+
+    static size_t authority_key(curlu const& u)
+    {
+        auto h = u.try_get(CURLUPART_HOST);
+        if(! h)
+            return 0;
+
+        auto s = u.try_get(CURLUPART_SCHEME);
+        auto p = u.try_get(CURLUPART_PORT);
+
+        return authority_key(s ? string_view(*s) : string_view(), string_view(*h), p ? string_view(*p) : string_view());
+    }
+
+    size_t body_buf_high_water() const noexcept
+    {
+        return _bodyBufHighWater.load(std::memory_order_relaxed);
+    }
+
+    size_t body_size_avg(size_t key)
+    {
+        std::lock_guard lg{_bodySizeMtx};
+
+        if(auto it = _bodySizeAvg.find(key); it != _bodySizeAvg.end())
+            return std::min(it->second, body_buf_high_water());
+        return 0;
+    }
+
+    void update_body_size_avg(size_t key, size_t n)
+    {
+        std::lock_guard lg{_bodySizeMtx};
+
+        if(_bodySizeAvg.size() >= max_body_size_avg_entries)
+            _bodySizeAvg.clear();
+
+        auto[it, added] = _bodySizeAvg.try_emplace(key, n);
+
+        if(! added) // exponential moving average with alpha = 1/8
+            it->second = it->second - it->second / 8 + n / 8;
+    }
+
     // called in curl_request.reset_all()
     void apply_default_opts(curl_request& cr)
     {
@@ -1242,6 +1446,13 @@ public:
         _noProxyList.clear();
     }
 
+    // recycled body buffer of curl_request larger than this will be released.
+    // this also caps the size pre-allocated for a body.
+    void set_body_buf_high_water(_B_<size_t> n) noexcept
+    {
+        _bodyBufHighWater.store(n.count(), std::memory_order_relaxed);
+    }
+
     ///
     template<_resizable_byte_buf_ B>
     aresult_task<> read_body(auto method, auto target, curl_fields fields, B&& b, auto... p)
@@ -1250,17 +1461,25 @@ public:
 
         JKL_CO_TRY(auto&& req, co_await acquire_request(p...));
 
-        co_return co_await req->fail_on_http_error() // otherwise user may only get an invalid body with no ec
-                            .method(method).target(target).reset_fields(std::move(fields))
-                            .read_body(bh, p...);
+        req->fail_on_http_error() // otherwise user may only get an invalid body with no ec
+            .method(method).target(target).reset_fields(std::move(fields))
+            .presize_body(bh);
+
+        JKL_CO_TRY(co_await req->read_body(bh, p...));
+
+        req->record_body_size(buf_size(bh));
+        co_return no_err;
     }
 
     template<_resizable_byte_buf_ B = string>
     aresult_task<B> return_body(auto method, auto target, curl_fields fields, auto... p)
     {
-        B b;
-        JKL_CO_TRY(co_await read_body(method, target, fields, b, p...));
-        co_return b;
+        JKL_CO_TRY(auto&& req, co_await acquire_request(p...));
+
+        req->fail_on_http_error() // otherwise user may only get an invalid body with no ec
+            .method(method).target(target).reset_fields(std::move(fields));
+
+        co_return co_await req->template return_body<B>(p...);
     }
 
     template<_resizable_byte_buf_ B = string>
@@ -7,6 +7,9 @@
 #include <jkl/result.hpp>
 #include <jkl/resolver.hpp>
 #include <jkl/ec_awaiter.hpp>
+#include <jkl/read_write.hpp>
+#include <jkl/zero_copy.hpp>
+#include <jkl/happy_eyeballs.hpp>
 
 
 namespace jkl{
@@ -108,15 +111,21 @@ public:
 
     template<class... P>
     aresult_task<endpoint_type> connect(aurl u, P... p)
+    {
+        resolver_t<protocol_type, executor_type> rsv(get_executor());
+        co_return co_await connect_with(rsv, std::move(u), p...);
+    }
+
+    // resolves with rsv (e.g.: resolver_t, ares_resolver), then races resolved endpoints(happy eyeballs).
+    template<class Resolver, class... P>
+    aresult_task<endpoint_type> connect_with(Resolver& rsv, aurl u, P... p)
     {
         if(auto ep = u.endpoint<protocol_type>())
             co_return co_await connect(*ep, p...);
 
-        resolver_t<protocol_type, executor_type> rsv(get_executor());
-
         JKL_CO_TRY(eps, co_await rsv.resolve(u.hostname(), u.real_port_or_protocol(), p...));
 
-        co_return co_await connect(eps, p...);
+        co_return co_await happy_eyeballs_connect(lowest_layer(), eps, p...);
     }
 
     template<class B, class... P>
@@ -143,6 +152,26 @@ public:
         return jkl::write_some_from(_s, b, pos, p...);
     }
 
+    // b: byte buf or const buffer sequence(e.g.: gather_bufs(header, body)), which is written with writev
+    template<class B, class... P>
+    auto write_all(B&& b, P... p)
+    {
+        return jkl::write_all(_s, std::forward<B>(b), p...);
+    }
+
+    // zero copy sending, see zero_copy.hpp
+    template<class... P>
+    auto send_file(synced_file& f, uint64_t offset, uint64_t n, P... p)
+    {
+        return jkl::send_file(_s, f, offset, n, p...);
+    }
+
+    template<class B, class... P>
+    auto send_zerocopy(B const& b, P... p)
+    {
+        return jkl::send_zerocopy(_s, b, p...);
+    }
+
 
     template<class B, class CompCond, class... P>
     auto read(B&& b, CompCond&& c, P... p)
@@ -251,6 +280,24 @@ public:
         return visit([&](auto& c){ return c.write_some_from(b, pos, p...); });
     }
 
+    template<class B, class... P>
+    auto write_all(B&& b, P... p)
+    {
+        return visit([&](auto& c){ return c.write_all(std::forward<B>(b), p...); });
+    }
+
+    template<class... P>
+    auto send_file(synced_file& f, uint64_t offset, uint64_t n, P... p)
+    {
+        return visit([&](auto& c){ return c.send_file(f, offset, n, p...); });
+    }
+
+    template<class B, class... P>
+    auto send_zerocopy(B const& b, P... p)
+    {
+        return visit([&](auto& c){ return c.send_zerocopy(b, p...); });
+    }
+
     template<class B, class CompCond, class... P>
     auto read(B&& b, CompCond&& c, P... p)
     {
@@ -326,6 +373,9 @@ public:
 
     void set_max_read_buf(_B_<size_t> n) noexcept { _maxRdBuf = n; }
 
+    // resume TLS sessions per host, c must outlive ssl_ctx()
+    void use_session_cache(ssl_session_cache& c) { ssl_ctx().use_session_cache(c); }
+
     // https://www.extrahop.com/company/blog/2016/tcp-nodelay-nagle-quickack-best-practices
     void set_no_delay_when_handshake(bool on = true) noexcept { _noDelayWhenHandshake = on; }
 
@@ -373,6 +423,7 @@ public:
                 JKL_CO_TRY(co_await conn.handshake(asio::ssl::stream_base::client, u, p...));
             }
 
+            ssl_session_cache::on_handshake_done(conn.stream_native_handle());
             co_return conn;
         }
 
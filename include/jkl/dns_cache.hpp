@@ -0,0 +1,479 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <jkl/task.hpp>
+#include <jkl/params.hpp>
+#include <jkl/result.hpp>
+#include <jkl/std_coro.hpp>
+#include <jkl/ec_awaiter.hpp>
+#include <jkl/util/str.hpp>
+#include <jkl/util/concepts.hpp>
+#include <jkl/util/type_traits.hpp>
+#include <jkl/util/stringify.hpp>
+#include <jkl/util/unordered_map_set.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/system_executor.hpp>
+#include <array>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <vector>
+#include <optional>
+#include <span>
+#include <algorithm>
+#if __has_include(<ares.h>)
+#   include <ares.h>
+#endif
+
+
+namespace jkl{
+
+
+// DNS cache in front of a resolver(resolver_t, ares_resolver or anything with the same resolve(host, service, p...)).
+// - records are cached for their TTL clamped into [minTtl, maxTtl], resolvers without TTL(resolver_t) use defaultTtl.
+// - NXDOMAIN/no data is cached for negativeTtl.
+// - concurrent lookups of the same name share a single query.
+// - entries hit at least prefetchMinHits times are refreshed in background when prefetchRatio of their TTL passed,
+//   and expired entries are served for at most staleTtl while being refreshed, so a known host never waits on DNS.
+// - the map is split into shards, each with its own lock.
+// The cache itself has the same resolve(host, service, p...), so it can be used wherever the resolver is, e.g.:
+//    ares_resolver rsv(ioc);
+//    dns_cache cache(rsv);
+//    co_await conn.connect_with(cache, url);
+// NOTE: queries run detached, the cache and resolver must outlive them.
+template<class Resolver>
+class dns_cache
+{
+public:
+    using resolver_type = Resolver;
+    using endpoint_type = typename Resolver::endpoint_type;
+    using endpoints_type = std::vector<endpoint_type>;
+    using addrs_ptr      = std::shared_ptr<endpoints_type const>;
+    using clock_type     = std::chrono::steady_clock;
+    using time_point     = clock_type::time_point;
+    using duration       = clock_type::duration;
+
+    // shares the cached endpoints instead of copying them, stays valid after the entry is refreshed or dropped
+    class results_type
+    {
+        addrs_ptr _addrs;
+        std::span<endpoint_type const> _eps;
+
+    public:
+        results_type() noexcept = default;
+        explicit results_type(addrs_ptr a) noexcept : _addrs{std::move(a)}, _eps{*_addrs} {}
+
+        auto begin() const noexcept { return _eps.begin(); }
+        auto end  () const noexcept { return _eps.end(); }
+        size_t size() const noexcept { return _eps.size(); }
+        bool  empty() const noexcept { return _eps.empty(); }
+        endpoint_type const& operator[](size_t i) const noexcept { return _eps[i]; }
+
+        addrs_ptr const& shared() const noexcept { return _addrs; }
+    };
+
+    static constexpr size_t shard_cnt = 16;
+
+private:
+
+    // a lookup shared by all concurrent callers of the same name
+    struct query
+    {
+        using handler_type = std::function<void(aerror_code const&, addrs_ptr)>;
+
+        struct waiting
+        {
+            uint64_t              id;
+            asio::any_io_executor ex;
+            handler_type          h;
+        };
+
+        // a caller waiting on the query, also the async object for ec_awaiter,
+        // so stop/timeout of the caller only abandons its own wait, not the shared query.
+        struct waiter
+        {
+            query&                q;
+            asio::any_io_executor ex; // resumes on it if set, otherwise on the thread completing the query
+            uint64_t              id = 0;
+
+            auto get_executor() const { return ex; }
+
+            void cancel()
+            {
+                std::lock_guard lg{q.mtx};
+                std::erase_if(q.waiters, [this](auto& w){ return w.id == id; });
+            }
+        };
+
+        std::mutex           mtx;
+        bool                 done = false;
+        aerror_code          err;
+        addrs_ptr            addrs;
+        std::vector<waiting> waiters;
+        uint64_t             lastId = 0;
+
+        static void invoke(asio::any_io_executor const& ex, handler_type h, aerror_code const& e, addrs_ptr a)
+        {
+            if(ex)
+                asio::post(ex, [h = std::move(h), e, a = std::move(a)]{ h(e, a); });
+            else
+                h(e, std::move(a));
+        }
+
+        // h is called when the query completes, or right away if it has completed,
+        // never inside add(), as the awaiting coroutine is still suspending then.
+        void add(waiter& w, handler_type h)
+        {
+            aerror_code e;
+            addrs_ptr   a;
+            {
+                std::lock_guard lg{mtx};
+
+                if(! done)
+                {
+                    w.id = ++lastId;
+                    waiters.push_back({w.id, w.ex, std::move(h)});
+                    return;
+                }
+
+                e = err;
+                a = addrs;
+            }
+
+            asio::post(w.ex ? w.ex : asio::any_io_executor(asio::system_executor()),
+                       [h = std::move(h), e, a = std::move(a)]{ h(e, a); });
+        }
+
+        void complete(aerror_code const& e, addrs_ptr const& a)
+        {
+            std::vector<waiting> ws;
+            {
+                std::lock_guard lg{mtx};
+                done  = true;
+                err   = e;
+                addrs = a;
+                ws.swap(waiters);
+            }
+
+            for(auto& w : ws)
+                invoke(w.ex, std::move(w.h), e, a);
+        }
+    };
+
+    struct entry
+    {
+        addrs_ptr   addrs;     // positive result
+        aerror_code err;       // negative result
+        time_point  fetched;
+        time_point  expiry;
+        time_point  refreshAt; // background refresh after this
+        uint32_t    hits = 0;  // since fetched
+        std::shared_ptr<query> inflight;
+    };
+
+    struct shard
+    {
+        std::mutex mtx;
+        unordered_flat_map<string, entry> map;
+    };
+
+    Resolver& _rsv;
+    std::array<shard, shard_cnt> _shards;
+
+    duration _minTtl      = std::chrono::seconds(5);
+    duration _maxTtl      = std::chrono::hours(1);
+    duration _defaultTtl  = std::chrono::seconds(60);
+    duration _negativeTtl = std::chrono::seconds(30);
+    duration _staleTtl    = std::chrono::seconds(30);
+    duration _queryTimeout = std::chrono::seconds(10);
+    double   _prefetchRatio   = 0.8;
+    uint32_t _prefetchMinHits = 2;
+    size_t   _maxEntriesPerShard = 65536 / shard_cnt;
+
+    static string to_string(auto const& s)
+    {
+        auto&& v = stringify(s);
+        return string(str_data(v), str_size(v));
+    }
+
+    static string make_key(auto const& host, auto const& service)
+    {
+        string k = to_string(host);
+        k += ':';
+        k += to_string(service);
+        return k;
+    }
+
+    shard& shard_of(string const& key) noexcept
+    {
+        return _shards[robin_hood_hash{}(key) % shard_cnt];
+    }
+
+    static bool is_negative(aerror_code const& e) noexcept
+    {
+        if(e == asio::error::host_not_found || e == asio::error::no_data)
+            return true;
+#ifdef ARES_ENOTFOUND
+        if(e.category().name() == std::string_view("c-ares"))
+            return e.value() == ARES_ENOTFOUND || e.value() == ARES_ENODATA;
+#endif
+        return false;
+    }
+
+    static auto to_endpoint(auto const& e)
+    {
+        if constexpr(requires{ e.endpoint(); })
+            return e.endpoint();
+        else
+            return e;
+    }
+
+    // should be locked
+    void trim(shard& s, time_point now)
+    {
+        if(s.map.size() < _maxEntriesPerShard)
+            return;
+
+        // drop what are not served anymore, then anything not in flight
+        for(int pass = 0; pass < 2 && s.map.size() >= _maxEntriesPerShard; ++pass)
+        {
+            for(auto it = s.map.begin(); it != s.map.end();)
+            {
+                bool drop = ! it->second.inflight && (pass || it->second.expiry + _staleTtl <= now);
+
+                if(drop)
+                    it = s.map.erase(it);
+                else
+                    ++it;
+            }
+        }
+    }
+
+    atask<> run_query(std::shared_ptr<query> q, string key, string host, string service)
+    {
+        auto r = co_await _rsv.resolve(host, service, p_expires_after(_queryTimeout));
+
+        aerror_code err;
+        addrs_ptr   addrs;
+        duration    ttl = _negativeTtl;
+
+        if(r)
+        {
+            auto eps = std::make_shared<endpoints_type>();
+
+            for(auto const& e : *r)
+                eps->emplace_back(to_endpoint(e));
+
+            if constexpr(requires{ r->ttl; })
+                ttl = std::clamp<duration>(r->ttl, _minTtl, _maxTtl);
+            else
+                ttl = _defaultTtl;
+
+            if(eps->empty())
+            {
+                err = asio::error::no_data;
+                ttl = _negativeTtl;
+            }
+            else
+                addrs = std::move(eps);
+        }
+        else
+        {
+            err = r.error();
+        }
+
+        {
+            auto& s = shard_of(key);
+            std::lock_guard lg{s.mtx};
+
+            auto now = clock_type::now();
+            auto it  = s.map.find(key);
+
+            if(it != s.map.end() && it->second.inflight == q)
+            {
+                auto& e = it->second;
+                e.inflight.reset();
+
+                // transient failures(e.g.: timeout, servfail) are not cached, a stale entry keeps serving
+                if(addrs || is_negative(err))
+                {
+                    e.addrs     = addrs;
+                    e.err       = err;
+                    e.fetched   = now;
+                    e.expiry    = now + ttl;
+                    e.refreshAt = now + std::chrono::duration_cast<duration>(ttl * _prefetchRatio);
+                    e.hits      = 0;
+                }
+                else if(! e.addrs && ! e.err)
+                {
+                    s.map.erase(it);
+                }
+            }
+        }
+
+        q->complete(err, addrs);
+    }
+
+public:
+    explicit dns_cache(Resolver& rsv) : _rsv{rsv} {}
+
+    dns_cache(dns_cache const&) = delete;
+    dns_cache& operator=(dns_cache const&) = delete;
+
+    Resolver& resolver() noexcept { return _rsv; }
+
+    // settings, should be set before use
+    void set_ttl_clamp(duration minTtl, duration maxTtl) noexcept { _minTtl = minTtl; _maxTtl = maxTtl; }
+    void set_default_ttl (duration d) noexcept { _defaultTtl  = d; }
+    void set_negative_ttl(duration d) noexcept { _negativeTtl = d; }
+    void set_stale_ttl   (duration d) noexcept { _staleTtl    = d; }
+    void set_query_timeout(duration d) noexcept { _queryTimeout = d; }
+    void set_prefetch(double ratio, uint32_t minHits) noexcept { _prefetchRatio = ratio; _prefetchMinHits = minHits; }
+    void set_max_entries(size_t n) noexcept { _maxEntriesPerShard = (std::max<size_t>)(n / shard_cnt, 1); }
+
+    // cached result without querying
+    std::optional<aresult<results_type>> lookup(auto const& host, auto const& service)
+    {
+        auto  key = make_key(host, service);
+        auto& s   = shard_of(key);
+
+        std::lock_guard lg{s.mtx};
+
+        auto it = s.map.find(key);
+
+        if(it == s.map.end() || (! it->second.addrs && ! it->second.err) || it->second.expiry <= clock_type::now())
+            return std::nullopt;
+
+        if(it->second.err)
+            return aresult<results_type>(it->second.err);
+        return aresult<results_type>(results_type(it->second.addrs));
+    }
+
+    // feeds a result obtained elsewhere, e.g.: by resolve_many()
+    void insert(auto const& host, auto const& service, endpoints_type eps, duration ttl)
+    {
+        auto  key = make_key(host, service);
+        auto& s   = shard_of(key);
+        auto  now = clock_type::now();
+
+        ttl = std::clamp(ttl, _minTtl, _maxTtl);
+
+        std::lock_guard lg{s.mtx};
+
+        trim(s, now);
+
+        auto& e = s.map[key];
+        e.addrs     = std::make_shared<endpoints_type const>(std::move(eps));
+        e.err       = {};
+        e.fetched   = now;
+        e.expiry    = now + ttl;
+        e.refreshAt = now + std::chrono::duration_cast<duration>(ttl * _prefetchRatio);
+        e.hits      = 0;
+    }
+
+    void erase(auto const& host, auto const& service)
+    {
+        auto  key = make_key(host, service);
+        auto& s   = shard_of(key);
+
+        std::lock_guard lg{s.mtx};
+
+        if(auto it = s.map.find(key); it != s.map.end() && ! it->second.inflight)
+            s.map.erase(it);
+    }
+
+    // p: params for make_ec_awaiter, p_enable_stop/p_expires_after apply to this caller's wait only,
+    //    the query keeps running for other callers and the cache, it expires after set_query_timeout().
+    //    p_resume_on(ex): a caller waiting on a query is resumed on ex, defaults to resolver's executor if it has one,
+    //    p_expires_after needs one of them.
+    template<class Host, class Service, class... P>
+        requires(_str_<Service> || _arithmetic_<Service>) // otherwise resolve(host, p...) below
+    aresult_task<results_type> resolve(Host const& host, Service const& service, P... p)
+    {
+        auto  key = make_key(host, service);
+        auto& s   = shard_of(key);
+
+        std::shared_ptr<query> q;
+        bool start = false; // the query is started by us, outside of the lock, as it may complete inline
+        std::optional<aresult<results_type>> cached;
+
+        {
+            std::lock_guard lg{s.mtx};
+
+            auto now = clock_type::now();
+            auto it  = s.map.find(key);
+
+            if(it == s.map.end())
+            {
+                trim(s, now);
+                it = s.map.try_emplace(key).first;
+            }
+
+            auto& e = it->second;
+
+            bool fresh = (e.addrs || e.err) && now < e.expiry;
+            bool stale = e.addrs && ! fresh && now < e.expiry + _staleTtl;
+
+            if(fresh || stale)
+            {
+                ++e.hits;
+
+                // refresh in background
+                if(! e.inflight && (stale || (e.addrs && now >= e.refreshAt && e.hits >= _prefetchMinHits)))
+                {
+                    q = e.inflight = std::make_shared<query>();
+                    start = true;
+                }
+
+                if(e.err)
+                    cached.emplace(e.err);
+                else
+                    cached.emplace(results_type(e.addrs));
+            }
+            else if(e.inflight)
+            {
+                q = e.inflight;
+            }
+            else
+            {
+                q = e.inflight = std::make_shared<query>();
+                start = true;
+            }
+        }
+
+        if(start)
+            spawn(run_query(q, key, to_string(host), to_string(service)));
+
+        if(cached)
+            co_return std::move(*cached);
+
+        asio::any_io_executor ex;
+        auto pex = make_params(p..., [](t_resume_on_t){ return null_op; })(t_resume_on);
+
+        if constexpr(! is_null_op_v<decltype(pex)>)
+            ex = pex;
+        else if constexpr(requires{ _rsv.get_executor(); })
+            ex = _rsv.get_executor();
+
+        typename query::waiter w{*q, std::move(ex)};
+
+        JKL_CO_TRY(auto addrs, co_await make_ec_awaiter<addrs_ptr>(w,
+            [&](auto&& h){ q->add(w, std::move(h)); },
+            p...));
+
+        co_return results_type(std::move(addrs));
+    }
+
+    // a coroutine too, so the empty service outlives the lookup
+    template<class Host, class... P>
+    aresult_task<results_type> resolve(Host const& host, P... p)
+    {
+        co_return co_await resolve(host, std::string_view(), p...);
+    }
+};
+
+
+} // namespace jkl
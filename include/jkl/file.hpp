@@ -38,14 +38,18 @@ public:
     aresult<std::uint64_t> size() const
     {
         aerror_code ec;
-        Impl::size(ec);
+        auto n = Impl::size(ec);
+        if(! ec)
+            return n;
         return ec;
     }
 
     aresult<std::uint64_t> pos() const
     {
         aerror_code ec;
-        Impl::pos(ec);
+        auto n = Impl::pos(ec);
+        if(! ec)
+            return n;
         return ec;
     }
 
@@ -63,9 +67,9 @@ public:
     aresult<size_t> read(_trivially_copyable_ auto* d, size_t n) const
     {
         aerror_code ec;
-        size_t nByte = Impl::read(d, n * sizeof(d), ec);
+        size_t nByte = Impl::read(d, n * sizeof(*d), ec);
         if(! ec)
-            return nByte / sizeof(d);
+            return nByte / sizeof(*d);
         return ec;
     }
 
@@ -87,9 +91,9 @@ public:
     aresult<size_t> write(_trivially_copyable_ auto* d, size_t n)
     {
         aerror_code ec;
-        size_t nByte = Impl::write(d, n * sizeof(d), ec);
+        size_t nByte = Impl::write(d, n * sizeof(*d), ec);
         if(! ec)
-            return nByte / sizeof(d);
+            return nByte / sizeof(*d);
         return ec;
     }
 
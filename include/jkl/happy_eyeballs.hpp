@@ -0,0 +1,195 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <jkl/task.hpp>
+#include <jkl/params.hpp>
+#include <jkl/result.hpp>
+#include <jkl/ec_awaiter.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/bind_executor.hpp>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <optional>
+#include <functional>
+
+
+namespace jkl{
+
+
+// RFC 8305 style racing connect:
+// endpoints are interleaved by address family starting with IPv6,
+// a new attempt is started every attemptDelay or as soon as the previous one failed,
+// the first established connection wins and the rest are cancelled.
+template<class Socket>
+class happy_eyeballs_op : public std::enable_shared_from_this<happy_eyeballs_op<Socket>>
+{
+public:
+    using socket_type   = Socket;
+    using executor_type = typename Socket::executor_type;
+    using protocol_type = typename Socket::protocol_type;
+    using endpoint_type = typename protocol_type::endpoint;
+
+private:
+    Socket& _s; // receives the winner
+    asio::strand<executor_type> _strand;
+    asio::steady_timer _timer;
+    std::chrono::steady_clock::duration _delay;
+
+    std::vector<endpoint_type>         _eps;
+    std::vector<std::optional<Socket>> _attempts;
+    size_t _next    = 0;
+    size_t _pending = 0;
+    bool   _done    = false;
+    aerror_code _lastEc = asio::error::host_not_found;
+
+    std::function<void(aerror_code const&, endpoint_type)> _h;
+
+    void start_next()
+    {
+        BOOST_ASSERT(! _done);
+        BOOST_ASSERT(_next < _eps.size());
+
+        size_t i = _next++;
+        ++_pending;
+
+        _attempts[i].emplace(_s.get_executor()).async_connect(_eps[i],
+            asio::bind_executor(_strand, [self = this->shared_from_this(), i](aerror_code const& ec){
+                self->on_connect(i, ec);
+            }));
+
+        if(_next < _eps.size())
+        {
+            _timer.expires_after(_delay); // also cancels previous wait
+            _timer.async_wait(
+                asio::bind_executor(_strand, [self = this->shared_from_this()](aerror_code const& ec){
+                    if(! ec && ! self->_done && self->_next < self->_eps.size())
+                        self->start_next();
+                }));
+        }
+    }
+
+    void on_connect(size_t i, aerror_code const& ec)
+    {
+        --_pending;
+
+        if(_done)
+            return;
+
+        if(ec)
+        {
+            _attempts[i].reset();
+            _lastEc = ec;
+
+            if(_next < _eps.size())
+                start_next(); // don't wait for the delay
+            else if(_pending == 0)
+                finish(ec, {});
+            return;
+        }
+
+        _s = std::move(*_attempts[i]);
+        finish(no_err, _eps[i]);
+    }
+
+    void finish(aerror_code const& ec, endpoint_type const& ep)
+    {
+        _done = true;
+        _timer.cancel();
+        close_attempts();
+
+        if(auto h = std::move(_h))
+            h(ec, ep);
+    }
+
+    void close_attempts()
+    {
+        for(auto& a : _attempts)
+        {
+            if(a)
+            {
+                aerror_code e;
+                a->close(e);
+            }
+        }
+    }
+
+public:
+    template<class Eps>
+    happy_eyeballs_op(Socket& s, Eps const& eps, std::chrono::nanoseconds attemptDelay)
+        : _s{s}, _strand{s.get_executor()}, _timer{s.get_executor()},
+          _delay{std::chrono::duration_cast<std::chrono::steady_clock::duration>(attemptDelay)}
+    {
+        std::vector<endpoint_type> v6, v4;
+
+        for(auto const& e : eps)
+        {
+            endpoint_type ep;
+
+            if constexpr(requires{ e.endpoint(); })
+                ep = e.endpoint();
+            else
+                ep = e;
+
+            (ep.address().is_v6() ? v6 : v4).emplace_back(ep);
+        }
+
+        _eps.reserve(v6.size() + v4.size());
+
+        for(size_t i = 0; i < std::max(v6.size(), v4.size()); ++i)
+        {
+            if(i < v6.size()) _eps.emplace_back(v6[i]);
+            if(i < v4.size()) _eps.emplace_back(v4[i]);
+        }
+
+        _attempts.resize(_eps.size());
+    }
+
+    auto get_executor() const { return _strand; }
+
+    template<class H>
+    void start(H&& h)
+    {
+        asio::post(_strand, [self = this->shared_from_this(), h = std::forward<H>(h)]() mutable {
+            if(self->_eps.empty())
+            {
+                h(self->_lastEc, endpoint_type{});
+                return;
+            }
+
+            self->_h = std::move(h);
+            self->start_next();
+        });
+    }
+
+    // may be called from any thread
+    void cancel()
+    {
+        asio::post(_strand, [self = this->shared_from_this()](){
+            if(! self->_done)
+                self->finish(asio::error::operation_aborted, {});
+        });
+    }
+};
+
+
+// eps: range of endpoints or resolver entries.
+// p: p_attempt_delay(dur) (default 250ms) and params for make_ec_awaiter.
+// returns the connected endpoint, s is only modified when succeeded.
+template<class Socket, class Eps, class... P>
+aresult_task<typename Socket::protocol_type::endpoint> happy_eyeballs_connect(Socket& s, Eps const& eps, P... p)
+{
+    using op_type = happy_eyeballs_op<Socket>;
+
+    auto delay = make_params(p..., p_attempt_delay(std::chrono::milliseconds(250)))(t_attempt_delay);
+    auto op = std::make_shared<op_type>(s, eps, delay);
+
+    co_return co_await make_ec_awaiter<typename op_type::endpoint_type>(*op,
+        [op](auto&& h){ op->start(std::move(h)); },
+        p...);
+}
+
+
+} // namespace jkl
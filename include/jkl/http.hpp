@@ -4,13 +4,29 @@
 #include <jkl/url.hpp>
 #include <jkl/tcp.hpp>
 #include <jkl/ssl.hpp>
+#include <jkl/gen.hpp>
 #include <jkl/task.hpp>
 #include <jkl/result.hpp>
+#include <jkl/res_pool.hpp>
+#include <jkl/rate_policy.hpp>
+#include <jkl/zero_copy.hpp>
 #include <jkl/ec_awaiter.hpp>
+#include <jkl/read_write.hpp>
+#include <jkl/read_buf_pool.hpp>
+#include <jkl/happy_eyeballs.hpp>
 #include <jkl/util/unit.hpp>
+#include <jkl/util/unordered_map_set.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/ssl/ssl_stream.hpp>
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <optional>
+#include <functional>
 
 
 namespace jkl{
@@ -23,25 +39,66 @@ using beast::unlimited_rate_policy;
 using beast::flat_buffer;
 
 
+// a body of a const buffer sequence, e.g.: gather_bufs(a, b), std::vector<asio::const_buffer>.
+// the serializer yields the header and the body buffers as one sequence, so they go out in a single writev,
+// and the body is never copied. Only referenced buffers are stored, they must outlive the write.
+//    http::response<bufseq_body<std::array<asio::const_buffer, 2>>> res{http::status::ok, 11};
+//    res.body() = gather_bufs(head, tail);
+//    res.prepare_payload();
+//    co_await conn.write_msg(res);
+template<_const_bufseq_ BufSeq>
+struct bufseq_body
+{
+    using value_type = BufSeq;
+
+    static std::uint64_t size(value_type const& v) noexcept
+    {
+        return asio::buffer_size(v);
+    }
+
+    class writer
+    {
+        value_type const& _v;
+
+    public:
+        using const_buffers_type = BufSeq;
+
+        template<bool IsReq, class Fields>
+        explicit writer(http::header<IsReq, Fields> const&, value_type const& v) : _v{v} {}
+
+        void init(aerror_code& e) { e = {}; }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(aerror_code& e)
+        {
+            e = {};
+            return {{_v, false}};
+        }
+    };
+};
+
+
 template<class Stream, class Req, class Res, class ReadBuf>
 class http_conn_t
 {
     Stream  _s;
     ReadBuf _rb;
+    // set along with the stream's, which can't be queried, for operations bypassing the stream
+    asio::steady_timer::time_point _expiry = asio::steady_timer::time_point::max();
 
     template<class M, class... P>
     auto do_read(M& m, P... p)
     {
-        return make_ec_awaiter<size_t>(
-            [&](auto&& h) { http::async_read(_s, _rb, m, std::move(h)); }
+        return make_ec_awaiter_c<size_t>(*this,
+            [&](auto&& h) { http::async_read(_s, _rb, m, std::move(h)); },
+            [&](size_t) { release_read_buf(); },
             p...);
     }
 
     template<class M, class... P>
     auto do_write(M& m, P... p)
     {
-        return make_ec_awaiter<size_t>(
-            [&](auto&& h) { http::async_write(_s, m, std::move(h)); }
+        return make_ec_awaiter<size_t>(*this,
+            [&](auto&& h) { http::async_write(_s, m, std::move(h)); },
             p...);
     }
 
@@ -64,9 +121,29 @@ public:
 
     //http_conn_t& operator=(socket_type&& s) { socket() = std::move(s); }
 
-    void set_max_read_buf(_B_<size_t> n) { if(n != max_read_buf()) _rb = ReadBuf(n.count()); }
+    // a pooled read buffer(e.g.: pooled_flat_buffer) only changes its limit, so the pooled storage is kept,
+    // other buffers are replaced as before, dropping what's buffered.
+    void set_max_read_buf(_B_<size_t> n)
+    {
+        if constexpr(requires{ _rb.pool(); _rb.max_size(n.count()); })
+            _rb.max_size(n.count());
+        else if(n != max_read_buf())
+            _rb = ReadBuf(n.count());
+    }
+
     _B_<size_t> max_read_buf() const noexcept { return _B_(_rb.max_size()); }
 
+    auto      & read_buf()       noexcept { return _rb; }
+    auto const& read_buf() const noexcept { return _rb; }
+
+    // returns the storage of a pooled read buffer(e.g.: pooled_flat_buffer) to its pool, if nothing is left unconsumed.
+    // called after each read, so connections idle between messages don't hold the buffer.
+    void release_read_buf() noexcept
+    {
+        if constexpr(requires{ _rb.release_if_idle(); })
+            _rb.release_if_idle();
+    }
+
     auto      & stream()       noexcept { return _s; }
     auto const& stream() const noexcept { return _s; }
     auto      & astream()       noexcept { return _s; }
@@ -93,9 +170,23 @@ public:
 
     void cancel() { next_layer().cancel(); }
     void close () { next_layer().close (); }
-    void expires_after(std::chrono::nanoseconds t) { next_layer().expires_after(t); }
-    void expires_at(asio::steady_timer::time_point t) { next_layer().expires_at(t); }
-    void expires_never() { next_layer().expires_never(); }
+    void expires_after(std::chrono::nanoseconds t)
+    {
+        next_layer().expires_after(t);
+        _expiry = asio::steady_timer::clock_type::now() + std::chrono::duration_cast<asio::steady_timer::duration>(t);
+    }
+
+    void expires_at(asio::steady_timer::time_point t)
+    {
+        next_layer().expires_at(t);
+        _expiry = t;
+    }
+
+    void expires_never()
+    {
+        next_layer().expires_never();
+        _expiry = asio::steady_timer::time_point::max();
+    }
     auto release_socket() { return next_layer().release_socket();}
 
     template<class T>
@@ -130,32 +221,207 @@ public:
     template<class... P> auto write_req(P... p) { return do_write(req, p...); }
     template<class... P> auto write_res(P... p) { return do_write(res, p...); }
 
+    // read into any message or parser other than req/res, e.g.: a request_parser with custom allocator
+    template<class M, class... P> auto read_msg (M& m, P... p) { return do_read (m, p...); }
+    template<class M, class... P> auto write_msg(M& m, P... p) { return do_write(m, p...); }
+
+    // raw write of a byte buf or const buffer sequence with writev, e.g.: a pre-serialized response
+    template<class B, class... P>
+    auto write_all(B&& b, P... p)
+    {
+        return jkl::write_all(*this, std::forward<B>(b), p...);
+    }
+
+
+    // streaming body, so large bodies never sit in memory entirely.
+    // reading:
+    //    http::response_parser<http::buffer_body> parser;
+    //    parser.body_limit(boost::none);
+    //    JKL_CO_TRY(co_await conn.read_header(parser));
+    //    auto g = conn.read_body_chunks(parser, KiB<size_t>(64));
+    //    while(auto c = co_await g.next())
+    //    {
+    //        JKL_CO_TRY(chunk, std::move(*c));
+    //        ... consume chunk, valid until next g.next() ...
+    //    }
+    // writing:
+    //    http::request<http::empty_body> req{http::verb::put, "/upload", 11};
+    //    JKL_CO_TRY(co_await conn.write_chunked(req, [&](std::span<char> b) -> aresult_task<size_t> { ... return 0 on eof; }));
+
+    // writes header of m with content length of what's left in f from its current position, then the content,
+    // with sendfile(2) if the stream is not TLS, see send_file().
+    // if f is truncated meanwhile, the message can't be completed as declared, then the connection is closed,
+    // so it won't be reused, and http::error::partial_message is returned.
+    template<bool IsReq, class Fields, class... P>
+    aresult_task<uint64_t> write_file(http::message<IsReq, http::empty_body, Fields>& m, synced_file& f, P... p)
+    {
+        JKL_CO_TRY(uint64_t size, f.size());
+        JKL_CO_TRY(uint64_t pos, f.pos());
+
+        m.content_length(size - pos);
+
+        http::serializer<IsReq, http::empty_body, Fields> sr{m};
+
+        JKL_CO_TRY(co_await make_ec_awaiter<size_t>(*this,
+            [&](auto&& h) { http::async_write_header(_s, sr, std::move(h)); },
+            p...));
+
+        JKL_CO_TRY(uint64_t sent, co_await send_file(*this, f, pos, size - pos, p...));
+
+        if(sent < size - pos)
+        {
+            aerror_code e;
+            lowest_layer().close(e);
+            co_return http::error::partial_message;
+        }
+
+        co_return sent;
+    }
+
+    template<class Parser, class... P>
+    auto read_header(Parser& parser, P... p)
+    {
+        return make_ec_awaiter<size_t>(*this,
+            [&](auto&& h) { http::async_read_header(_s, _rb, parser, std::move(h)); },
+            p...);
+    }
+
+    // yields body pieces of at most bufSize, which are valid until next yield, an error is always the last yield.
+    // parser: http::parser<IsReq, http::buffer_body, ...> whose header has been read.
+    template<class Parser, class... P>
+    agen<aresult<std::span<char const>>> read_body_chunks(Parser& parser, _B_<size_t> bufSize, P... p)
+    {
+        std::unique_ptr<char[]> buf(new char[bufSize.count()]);
+
+        while(! parser.is_done())
+        {
+            auto& body = parser.get().body();
+            body.data = buf.get();
+            body.size = bufSize.count();
+
+            auto r = co_await make_ec_awaiter<size_t>(*this,
+                [&](auto&& h) { http::async_read_some(_s, _rb, parser, std::move(h)); },
+                p...);
+
+            // need_buffer: buf is full
+            if(! r && r.error() != http::error::need_buffer)
+            {
+                co_yield aresult<std::span<char const>>(r.error());
+                co_return;
+            }
+
+            if(size_t n = bufSize.count() - body.size)
+                co_yield aresult<std::span<char const>>(std::span<char const>(buf.get(), n));
+        }
+
+        release_read_buf();
+    }
+
+    template<class B, class... P>
+    auto write_chunk(B const& b, P... p)
+    {
+        return make_ec_awaiter<size_t>(*this,
+            [&, c = http::make_chunk(b)](auto&& h) { asio::async_write(_s, c, std::move(h)); },
+            p...);
+    }
+
+    template<class... P>
+    auto write_last_chunk(P... p)
+    {
+        return make_ec_awaiter<size_t>(*this,
+            [&](auto&& h) { asio::async_write(_s, http::make_chunk_last(), std::move(h)); },
+            p...);
+    }
+
+    // writes header of m with chunked transfer encoding, then pipes the body from src through a buffer of bufSize.
+    // src: (std::span<char>) -> [co_awaitable] aresult<size_t>, returns size read into the span, 0 on eof.
+    template<bool IsReq, class Fields, class Src, class... P>
+    aresult_task<> write_chunked(http::message<IsReq, http::empty_body, Fields>& m, Src src,
+                                 _B_<size_t> bufSize = KiB<size_t>(64), P... p)
+    {
+        m.chunked(true);
+
+        http::serializer<IsReq, http::empty_body, Fields> sr{m};
+
+        JKL_CO_TRY(co_await make_ec_awaiter<size_t>(*this,
+            [&](auto&& h) { http::async_write_header(_s, sr, std::move(h)); },
+            p...));
+
+        std::unique_ptr<char[]> buf(new char[bufSize.count()]);
+
+        for(;;)
+        {
+            std::span<char> b(buf.get(), bufSize.count());
+
+            size_t n = 0;
+
+            if constexpr(_co_awaitable_<std::invoke_result_t<Src&, std::span<char>>>)
+            {
+                JKL_CO_TRY(r, co_await src(b));
+                n = r;
+            }
+            else
+            {
+                JKL_CO_TRY(r, src(b));
+                n = r;
+            }
+
+            if(n == 0)
+                break;
+
+            JKL_CO_TRY(co_await write_chunk(asio::buffer(buf.get(), n), p...));
+        }
+
+        JKL_CO_TRY(co_await write_last_chunk(p...));
+        co_return no_err;
+    }
+
     template<class Ep, class... P>
     auto connect_endpoint(Ep&& ep, P... p)
     {
-        return make_ec_awaiter(
+        return make_ec_awaiter<void>(*this,
             [&, ep = std::forward<Ep>(ep)](auto&& h){ next_layer().async_connect(ep, std::move(h)); },
             p...);
     }
 
     template<class... P>
     aresult_task<> connect(aurl u, P... p)
+    {
+        tcp_resolver_t<executor_type> rsv(get_executor());
+        co_return co_await connect_with(rsv, std::move(u), p...);
+    }
+
+    // resolves with rsv (e.g.: resolver_t, ares_resolver), then races resolved endpoints(happy eyeballs).
+    // the connecting is timed by p_expires_after() in p, or else by expires_after()/expires_at() of this.
+    template<class Resolver, class... P>
+    aresult_task<> connect_with(Resolver& rsv, aurl u, P... p)
     {
         if(auto e = u.endpoint())
             co_return co_await connect_endpoint(*e, p...);
 
-        tcp_resolver_t<executor_type> rsv(get_executor());
-
         JKL_CO_TRY(eps, co_await rsv.resolve(u.hostname(), u.real_port_or_protocol(), p...));
 
-        co_return co_await connect_endpoint(eps, p...);
+        // happy_eyeballs_connect() works on the socket, which isn't timed by the stream,
+        // so the stream's expiry is passed on, unless p has one.
+        if constexpr(std::is_same_v<decltype(make_params(p..., p_expires_never)(t_expiry_dur)), null_op_t>)
+        {
+            if(_expiry != asio::steady_timer::time_point::max())
+            {
+                auto left = (std::max)(_expiry - asio::steady_timer::clock_type::now(), asio::steady_timer::duration::zero());
+                JKL_CO_TRY(co_await happy_eyeballs_connect(socket(), eps, p..., p_expires_after(left)));
+                co_return no_err;
+            }
+        }
+
+        JKL_CO_TRY(co_await happy_eyeballs_connect(socket(), eps, p...));
+        co_return no_err;
     }
 
     template<class... P>
     auto shutdown(P... p)
     {
         if constexpr(requires{ _s.async_shutdown(null_op); })
-            return make_ec_awaiter(
+            return make_ec_awaiter<void>(*this,
                 [&](auto&& h){ _s.async_shutdown(std::move(h)); },
                 p...);
         else
@@ -173,7 +439,13 @@ public:
     template<class... P>
     auto handshake(asio::ssl::stream_base::handshake_type t, P... p)
     {
-        return make_ec_awaiter(
+        if(t == asio::ssl::stream_base::client)
+        {
+            aerror_code e;
+            ssl_session_cache::try_resume(stream_native_handle(), lowest_layer().remote_endpoint(e).port());
+        }
+
+        return make_ec_awaiter<void>(*this,
             [&, t](auto&& h){ _s.async_handshake(t, std::move(h)); },
             p...);
     }
@@ -181,7 +453,13 @@ public:
     template<class B, class... P>
     auto buffered_handshake(asio::ssl::stream_base::handshake_type t, B& buf, P... p)
     {
-        return make_ec_awaiter(
+        if(t == asio::ssl::stream_base::client)
+        {
+            aerror_code e;
+            ssl_session_cache::try_resume(stream_native_handle(), lowest_layer().remote_endpoint(e).port());
+        }
+
+        return make_ec_awaiter<void>(*this,
             [&, t, b = asio_buf(b)](auto&& h){ _s.async_handshake(t, b, std::move(h)); },
         p...);
     }
@@ -275,6 +553,13 @@ public:
     template<class... A>
     explicit basic_var_stream(A&&... args) : _v(std::forward<A>(args)...) {}
 
+    executor_type get_executor() noexcept
+    {
+        return std::visit([](auto& s){ return s.get_executor(); }, _v);
+    }
+
+    bool is_ssl() const noexcept { return std::holds_alternative<ssl_stream_type>(_v); }
+
     auto& next_layer()
     {
         return std::visit([](auto& s) -> auto& { return get_next_layer(s); }, _v);
@@ -362,6 +647,56 @@ class http_conn_factory
     _B_<size_t> _maxRdBuf = SIZE_MAX;
     bool        _noDelayWhenHandshake = false;
 
+    std::shared_ptr<shared_bandwidth> _bw;
+    unordered_flat_map<std::string, std::shared_ptr<shared_bandwidth>> _hostBw;
+
+    using tcp_endpoints = std::vector<asio::ip::tcp::endpoint>;
+
+    // params of connect() passed through the type erased _resolve
+    struct resolve_params
+    {
+        std::optional<std::chrono::nanoseconds> expiry;
+        bool enableStop = false;
+    };
+
+    std::function<aresult_task<tcp_endpoints>(string, string, resolve_params)> _resolve;
+
+    // adapts _resolve for conn.connect_with()
+    struct fn_resolver
+    {
+        http_conn_factory& f;
+
+        template<class... P>
+        auto resolve(auto const& host, auto const& service, P... p)
+        {
+            auto params = make_params(p..., p_disable_stop, p_expires_never);
+
+            resolve_params rp;
+            rp.enableStop = params(t_stop_enabled);
+
+            if constexpr(! std::is_same_v<decltype(params(t_expiry_dur)), null_op_t>)
+                rp.expiry = std::chrono::duration_cast<std::chrono::nanoseconds>(params(t_expiry_dur));
+
+            return f._resolve(string(str_data(host), str_size(host)), string(str_data(service), str_size(service)), rp);
+        }
+    };
+
+    template<class Conn, class... P>
+    aresult_task<> connect_conn(Conn& conn, aurl const& u, P... p)
+    {
+        if(_resolve)
+        {
+            fn_resolver rsv{*this};
+            JKL_CO_TRY(co_await conn.connect_with(rsv, u, p...));
+        }
+        else
+        {
+            JKL_CO_TRY(co_await conn.connect(u, p...));
+        }
+
+        co_return no_err;
+    }
+
 public:
     explicit http_conn_factory(asio::io_context& ioc = default_ioc())
         : _ioc(&ioc)
@@ -387,9 +722,61 @@ public:
 
     void set_max_read_buf(_B_<size_t> n) noexcept { _maxRdBuf = n; }
 
+    // resume TLS sessions per host, c must outlive ssl_ctx()
+    void use_session_cache(ssl_session_cache& c) { ssl_ctx().use_session_cache(c); }
+
     // https://www.extrahop.com/company/blog/2016/tcp-nodelay-nagle-quickack-best-practices
     void set_no_delay_when_handshake(bool on = true) noexcept { _noDelayWhenHandshake = on; }
 
+    // resolves through r(e.g.: dns_cache, ares_resolver) instead of a new tcp resolver for each connection.
+    // r must outlive the factory.
+    template<class R>
+    void use_resolver(R& r)
+    {
+        _resolve = [&r](string host, string service, resolve_params rp) -> aresult_task<tcp_endpoints>
+        {
+            auto resolve = [&](auto... p) -> aresult_task<tcp_endpoints>
+            {
+                JKL_CO_TRY(auto eps, co_await r.resolve(host, service, p...));
+
+                tcp_endpoints v;
+
+                for(auto const& e : eps)
+                {
+                    if constexpr(requires{ e.endpoint(); })
+                        v.emplace_back(e.endpoint());
+                    else
+                        v.emplace_back(e);
+                }
+
+                co_return v;
+            };
+
+            if(rp.expiry && rp.enableStop)
+                co_return co_await resolve(p_expires_after(*rp.expiry), p_enable_stop);
+            if(rp.expiry)
+                co_return co_await resolve(p_expires_after(*rp.expiry));
+            if(rp.enableStop)
+                co_return co_await resolve(p_enable_stop);
+            co_return co_await resolve();
+        };
+    }
+
+    // connections with shared_rate_policy are attached to the bandwidth of their host if set, otherwise to bw.
+    // should be set before connecting.
+    void set_bandwidth(std::shared_ptr<shared_bandwidth> bw) noexcept { _bw = std::move(bw); }
+    void set_host_bandwidth(std::string host, std::shared_ptr<shared_bandwidth> bw)
+    {
+        _hostBw.insert_or_assign(std::move(host), std::move(bw));
+    }
+
+    std::shared_ptr<shared_bandwidth> bandwidth_for(std::string_view host) const
+    {
+        if(auto it = _hostBw.find(host); it != _hostBw.end())
+            return it->second;
+        return _bw;
+    }
+
     template<
         class RatePolicy = unlimited_rate_policy,
         class Req        = http::request<http::string_body>,
@@ -410,8 +797,11 @@ public:
             
             if(_maxRdBuf != _B_<size_t>(SIZE_MAX))
                 conn.set_max_read_buf(_maxRdBuf);
+
+            if constexpr(std::is_same_v<RatePolicy, shared_rate_policy>)
+                conn.rate_policy().attach(bandwidth_for(u.hostname()));
             
-            JKL_CO_TRY(co_await conn.connect(u, p...));
+            JKL_CO_TRY(co_await connect_conn(conn, u, p...));
             co_return conn;
         }
 
@@ -422,6 +812,9 @@ public:
             if(_maxRdBuf != _B_<size_t>(SIZE_MAX))
                 conn.set_max_read_buf(_maxRdBuf);
 
+            if constexpr(std::is_same_v<RatePolicy, shared_rate_policy>)
+                conn.rate_policy().attach(bandwidth_for(u.hostname()));
+
             if(u.hostname().size())
                 JKL_CO_TRY(conn.set_sni_hostname(u.hostname()));
 
@@ -432,7 +825,7 @@ public:
             if(_verifyCallback)
                 JKL_CO_TRY(conn.set_verify_callback(_verifyCallback));
 
-            JKL_CO_TRY(co_await conn.connect(u, p...));
+            JKL_CO_TRY(co_await connect_conn(conn, u, p...));
             
             if(_noDelayWhenHandshake)
             {
@@ -458,6 +851,7 @@ public:
                 JKL_CO_TRY(co_await conn.handshake(asio::ssl::stream_base::client, u, p...));
             }
 
+            ssl_session_cache::on_handshake_done(conn.stream_native_handle());
             co_return conn;
         }
 
@@ -473,9 +867,297 @@ public:
         class... P>
     auto connect(aurl u, P... p)
     {
-        return connect_ex(std::move(u), io_ctx().get_executor(), p...);
+        return connect_ex<RatePolicy, Req, Res, ReadBuf, Executor>(std::move(u), Executor(io_ctx().get_executor()), p...);
+    }
+};
+
+
+
+// keep-alive connections pooled by (scheme, host, port), built upon http_conn_factory.
+// idle connections are closed by a timer once they exceed the idle timeout or max requests, the timer runs
+// only while any connection is idle, but keeps io_context::run() from returning meanwhile.
+// typical usage:
+//    http_conn_pool pool(factory);
+//    JKL_CO_TRY(auto&& h, co_await pool.acquire(url, ...));
+//    auto& conn = h->conn();
+//    JKL_CO_TRY(co_await conn.write_req(...));
+//    JKL_CO_TRY(co_await conn.read_res(...));
+//    h->set_reusable(conn.res.keep_alive()); // otherwise the connection will be closed when h is recycled
+template<
+    class RatePolicy = unlimited_rate_policy,
+    class Req        = http::request<http::string_body>,
+    class Res        = http::response<http::dynamic_body>,
+    class ReadBuf    = flat_buffer,
+    class Executor   = asio::executor
+>
+class http_conn_pool_t
+{
+public:
+    using conn_type  = http_var_conn_t<RatePolicy, Req, Res, ReadBuf, Executor>;
+    using clock_type = std::chrono::steady_clock;
+
+    class conn_slot
+    {
+        friend class http_conn_pool_t;
+
+        std::optional<conn_type> _conn;
+        clock_type::time_point   _lastUsed;
+        size_t _requests = 0; // requests served by current connection
+        bool   _reusable = false;
+
+        // whether peer closed the connection or sent something unexpected while idle
+        bool alive() noexcept
+        {
+            auto& s = _conn->socket();
+
+            if(! s.is_open())
+                return false;
+
+            aerror_code e;
+            bool nb = s.non_blocking();
+
+            if(! nb)
+                s.non_blocking(true, e);
+
+            char c;
+            s.receive(asio::buffer(&c, 1), asio::socket_base::message_peek, e);
+
+            if(! nb)
+            {
+                aerror_code e2;
+                s.non_blocking(false, e2);
+            }
+
+            return e == asio::error::would_block;
+        }
+
+        void on_recycle() noexcept
+        {
+            if(_conn && std::exchange(_reusable, false))
+                _lastUsed = clock_type::now();
+            else
+                _conn.reset();
+        }
+
+    public:
+        bool has_conn() const noexcept { return _conn.has_value(); }
+
+        conn_type& conn() noexcept { BOOST_ASSERT(_conn); return *_conn; }
+
+        // should be called after a successful request/response exchange,
+        // usually with res.keep_alive()
+        void set_reusable(bool on = true) noexcept { _reusable = on; }
+
+        size_t requests() const noexcept { return _requests; }
+    };
+
+    using pool_map_type = res_pool_map<string, conn_slot>;
+    using res_holder    = typename pool_map_type::res_holder;
+
+private:
+    // closes idle connections when they expire, armed when a connection is returned to the pool,
+    // and re-armed for the earliest expiry while any stays idle.
+    struct idle_sweeper
+    {
+        std::mutex         lifeMtx; // held by a sweep and by the destructor
+        http_conn_pool_t*  pool;    // null once the pool is destroyed
+
+        std::mutex         timerMtx; // guards all below
+        asio::steady_timer timer;
+        bool               armed = false;
+        std::optional<clock_type::time_point> requested; // earliest expiry asked by arm_sweep() since last sweep
+
+        idle_sweeper(http_conn_pool_t& p, asio::io_context& ioc) : pool{&p}, timer{ioc} {}
+    };
+
+    http_conn_factory& _factory;
+    pool_map_type      _pools;
+    std::shared_ptr<idle_sweeper> _sweeper;
+
+    std::atomic<clock_type::duration> _idleTimeout = std::chrono::seconds(30);
+    std::atomic_size_t                _maxRequests = 100;
+
+    static string pool_key(aurl const& u)
+    {
+        return cat_str(u.scheme(), "://", u.hostname(), ':', u.real_port_or_protocol());
+    }
+
+    bool reusable(conn_slot& s) const noexcept
+    {
+        return s._requests < _maxRequests.load(std::memory_order_relaxed)
+            && clock_type::now() - s._lastUsed < _idleTimeout.load(std::memory_order_relaxed)
+            && s.alive();
+    }
+
+    // closes idle connections which are expired or served enough requests, returns when the next one expires,
+    // if any remains. the pools are locked only to take the connections out, they are closed after that.
+    // peer closed connections are not probed here, acquire() finds them.
+    std::optional<clock_type::time_point> close_idle()
+    {
+        std::optional<clock_type::time_point> next;
+        std::vector<conn_type> expired;
+
+        auto const idle   = _idleTimeout.load(std::memory_order_relaxed);
+        auto const maxReq = _maxRequests.load(std::memory_order_relaxed);
+        auto const now    = clock_type::now();
+
+        _pools.for_each_pool([&](auto& p)
+        {
+            p.for_each_unused([&](conn_slot& s)
+            {
+                if(! s._conn)
+                    return;
+
+                if(s._requests >= maxReq || now - s._lastUsed >= idle)
+                {
+                    expired.emplace_back(std::move(*s._conn));
+                    s._conn.reset();
+                    return;
+                }
+
+                if(! next || s._lastUsed + idle < *next)
+                    next = s._lastUsed + idle;
+            });
+        });
+
+        expired.clear();
+        return next;
+    }
+
+    // should be locked by timerMtx
+    static void arm_sweep_locked(std::shared_ptr<idle_sweeper> const& sw, clock_type::time_point at)
+    {
+        if(sw->armed && sw->timer.expiry() <= at)
+            return;
+
+        sw->armed = true;
+        sw->timer.expires_at(at); // cancels the later one if any
+        sw->timer.async_wait([sw](aerror_code const& ec)
+        {
+            if(ec != asio::error::operation_aborted)
+                sweep(sw);
+        });
+    }
+
+    static void arm_sweep(std::shared_ptr<idle_sweeper> const& sw, clock_type::time_point at)
+    {
+        std::lock_guard lg{sw->timerMtx};
+
+        // also kept for next sweep, since the connection is put into the pool after this,
+        // a sweep already due may miss it.
+        if(! sw->requested || at < *sw->requested)
+            sw->requested = at;
+
+        arm_sweep_locked(sw, at);
+    }
+
+    static void sweep(std::shared_ptr<idle_sweeper> const& sw)
+    {
+        std::lock_guard lg{sw->lifeMtx};
+
+        if(! sw->pool)
+            return;
+
+        std::optional<clock_type::time_point> requested;
+        {
+            std::lock_guard tl{sw->timerMtx};
+            sw->armed = false;
+            requested = std::exchange(sw->requested, std::nullopt);
+        }
+
+        auto next = sw->pool->close_idle();
+
+        if(requested && (! next || *requested < *next))
+            next = requested;
+
+        if(next)
+        {
+            std::lock_guard tl{sw->timerMtx};
+            arm_sweep_locked(sw, *next);
+        }
+    }
+
+public:
+    // maxConnsPerHost: max connections for each (scheme, host, port)
+    explicit http_conn_pool_t(http_conn_factory& f, size_t maxConnsPerHost = 6)
+        : _factory{f},
+          _pools{maxConnsPerHost, [](auto&& emplace){ emplace(); },
+                 [this](conn_slot& s)
+                 {
+                     s.on_recycle();
+
+                     if(s._conn)
+                         arm_sweep(_sweeper, s._lastUsed + _idleTimeout.load(std::memory_order_relaxed));
+                 },
+                 f.io_ctx()},
+          _sweeper{std::make_shared<idle_sweeper>(*this, f.io_ctx())}
+    {}
+
+    ~http_conn_pool_t()
+    {
+        std::lock_guard lg{_sweeper->lifeMtx};
+        _sweeper->pool = nullptr;
+
+        std::lock_guard tl{_sweeper->timerMtx};
+        _sweeper->timer.cancel();
+    }
+
+    http_conn_pool_t(http_conn_pool_t const&) = delete;
+    http_conn_pool_t& operator=(http_conn_pool_t const&) = delete;
+
+    http_conn_factory& factory() noexcept { return _factory; }
+    pool_map_type& pools() noexcept { return _pools; }
+
+    // idle connection exceeds this will be closed, takes effect from next time the sweep timer is armed
+    void set_idle_timeout(std::chrono::nanoseconds t) noexcept
+    {
+        _idleTimeout.store(std::chrono::duration_cast<clock_type::duration>(t), std::memory_order_relaxed);
+    }
+
+    // connection served this many requests will be closed instead of being reused
+    void set_max_requests_per_conn(size_t n) noexcept
+    {
+        BOOST_ASSERT(n > 0);
+        _maxRequests.store(n, std::memory_order_relaxed);
+    }
+
+    // p: params for both acquiring from pool and connecting
+    template<class... P>
+    aresult_task<res_holder> acquire(aurl u, P... p)
+    {
+        JKL_CO_TRY(auto&& h, co_await _pools.acquire(pool_key(u), p...));
+
+        conn_slot& s = *h;
+
+        if(s._conn && ! reusable(s))
+            s._conn.reset();
+
+        if(! s._conn)
+        {
+            JKL_CO_TRY(auto&& c, co_await _factory.template connect<RatePolicy, Req, Res, ReadBuf, Executor>(u, p...));
+            s._conn.emplace(std::move(c));
+            s._requests = 0;
+        }
+
+        ++s._requests;
+        s._reusable = false;
+
+        co_return std::move(h);
+    }
+
+    // opens a connection to u ahead of time, and leaves it idle in the pool, e.g.: for hosts just resolved.
+    // does nothing if an idle connection is available.
+    template<class... P>
+    aresult_task<> prewarm(aurl u, P... p)
+    {
+        JKL_CO_TRY(auto&& h, co_await acquire(std::move(u), p...));
+
+        --h->_requests;
+        h->_reusable = true;
+        co_return no_err;
     }
 };
 
+using http_conn_pool = http_conn_pool_t<>;
 
 } // namespace jkl
\ No newline at end of file
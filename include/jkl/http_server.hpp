@@ -0,0 +1,298 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <jkl/ioc.hpp>
+#include <jkl/http.hpp>
+#include <jkl/task.hpp>
+#include <jkl/timer.hpp>
+#include <jkl/params.hpp>
+#include <jkl/result.hpp>
+#include <jkl/acceptor.hpp>
+#include <jkl/util/log.hpp>
+#include <jkl/util/unit.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/http.hpp>
+#include <tuple>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <memory_resource>
+
+
+namespace jkl{
+
+
+// requests are allocated from a per-connection arena, which is released after each request
+using http_arena_alloc       = std::pmr::polymorphic_allocator<char>;
+using http_arena_fields      = http::basic_fields<http_arena_alloc>;
+using http_arena_string_body = http::basic_string_body<char, std::char_traits<char>, http_arena_alloc>;
+
+using http_server_request  = http::request<http_arena_string_body, http_arena_fields>;
+using http_server_response = http::response<http::string_body>;
+
+
+// HTTP/1.1 server, one listener per io_context of an ioc_pool(SO_REUSEPORT), one atask per connection.
+// Requests of a connection are processed in order, pipelined requests are parsed from the read buffer without
+// extra reading, and responses are written in the same order.
+//
+// Handler: (http_server_request&, http_server_response&) -> void or co_awaitable,
+//          may be called concurrently from any thread of the pool.
+// typical usage:
+//    ioc_pool iocs(4);
+//    http_server server(iocs, [](auto& req, auto& res) -> atask<> { ... co_return; });
+//    server.listen({asio::ip::tcp::v4(), 8080}).throw_on_error();
+//    iocs.start(4);
+//    auto t = server.run();
+//    signal_set_request_stop_guard sg(t); // drains on SIGINT/SIGTERM
+//    t.start_join();
+template<class Handler>
+class http_server
+{
+public:
+    using executor_type = asio::io_context::executor_type;
+    using acceptor_type = multi_acceptor<asio::ip::tcp>;
+    using socket_type   = typename acceptor_type::socket_type;
+    using conn_type     = http_conn_t<beast::basic_stream<asio::ip::tcp, executor_type>,
+                                      http::request<http::empty_body>, http_server_response, flat_buffer>;
+    using request_type  = http_server_request;
+    using response_type = http_server_response;
+    using duration      = std::chrono::steady_clock::duration;
+
+private:
+    Handler       _handler;
+    acceptor_type _acceptor;
+    std::stop_source   _stop{std::nostopstate};  // for accept loops and connections
+    std::stop_source   _abort{std::nostopstate}; // closes connections still alive after drain timeout
+    std::atomic_size_t _live = 0;                // running accept loops and connections
+
+    _B_<size_t> _bodyLimit     = MiB<size_t>(1);
+    size_t      _arenaInitSize = 4096;
+    duration    _readTimeout      = std::chrono::seconds(30);
+    duration    _keepAliveTimeout = std::chrono::seconds(15);
+    duration    _writeTimeout     = std::chrono::seconds(30);
+    duration    _drainTimeout     = std::chrono::seconds(10);
+
+    static void reset_response(response_type& res, request_type const& req)
+    {
+        auto body = std::move(res.body()); // reuse its capacity
+        body.clear();
+        res = {};
+        res.body() = std::move(body);
+        res.version(req.version());
+        res.result(http::status::ok);
+        res.keep_alive(req.keep_alive());
+    }
+
+    atask<> invoke_handler(request_type& req, response_type& res)
+    {
+        try
+        {
+            if constexpr(_co_awaitable_<std::invoke_result_t<Handler&, request_type&, response_type&>>)
+                co_await _handler(req, res);
+            else
+                _handler(req, res);
+
+            co_return;
+        }
+        catch(std::exception& e)
+        {
+            JKL_ERR << "http_server: " << e.what();
+        }
+        catch(...)
+        {
+            JKL_ERR << "http_server: unknown error";
+        }
+
+        reset_response(res, req);
+        res.result(http::status::internal_server_error);
+        res.keep_alive(false);
+    }
+
+    atask<> serve(socket_type sock, bool reschedule)
+    {
+        if(reschedule)
+            co_await schedule_on(sock.get_executor());
+
+        auto pc = std::make_shared<conn_type>(std::move(sock));
+        auto& conn = *pc;
+        (void)conn.set_option(asio::ip::tcp::no_delay(true));
+
+        // on abort, the socket is closed on its own executor, so pending reading/writing completes
+        std::stop_callback abortCb(_abort.get_token(), [wc = std::weak_ptr<conn_type>(pc)]
+        {
+            if(auto c = wc.lock())
+            {
+                asio::post(c->get_executor(), [wc]
+                {
+                    if(auto c = wc.lock())
+                    {
+                        aerror_code e;
+                        c->socket().close(e);
+                    }
+                });
+            }
+        });
+
+        std::unique_ptr<std::byte[]> arenaBuf(new std::byte[_arenaInitSize]);
+        std::pmr::monotonic_buffer_resource arena(arenaBuf.get(), _arenaInitSize);
+
+        for(bool first = true, keepAlive = true; keepAlive; first = false)
+        {
+            {
+                http::request_parser<http_arena_string_body, http_arena_alloc> parser(
+                    std::piecewise_construct,
+                    std::make_tuple(http_arena_alloc(&arena)),
+                    std::make_tuple(http_arena_alloc(&arena)));
+
+                parser.body_limit(_bodyLimit.count());
+
+                // reading is stopped on drain, so idle keep-alive connections close immediately
+                conn.expires_after(first ? _readTimeout : _keepAliveTimeout);
+
+                if(! co_await conn.read_msg(parser, p_enable_stop))
+                    break;
+
+                auto& req = parser.get();
+                auto& res = conn.res;
+
+                reset_response(res, req);
+                co_await invoke_handler(req, res);
+
+                keepAlive = req.keep_alive() && res.keep_alive() && ! co_await stop_requested();
+                res.keep_alive(keepAlive);
+                res.prepare_payload();
+
+                // in-flight request will be completed even when draining
+                conn.expires_after(_writeTimeout);
+
+                if(! co_await conn.write_res())
+                    break;
+            } // request must be destroyed before releasing arena
+
+            arena.release();
+        }
+
+        aerror_code e;
+        conn.socket().shutdown(asio::socket_base::shutdown_send, e);
+
+        pc.reset();
+        _live.fetch_sub(1, std::memory_order_release);
+    }
+
+    atask<> accept_loop(size_t i)
+    {
+        bool spread = ! _acceptor.per_ioc();
+
+        for(;;)
+        {
+            auto r = co_await _acceptor.accept(i, p_enable_stop);
+
+            if(! r)
+            {
+                if(r.error() == asio::error::operation_aborted || co_await stop_requested())
+                    break;
+
+                // e.g.: too many open files, back off a little
+                JKL_WARN << "http_server: accept: " << r.error().message();
+
+                steady_timer t(_acceptor.get(i).get_executor());
+                co_await t.wait(std::chrono::milliseconds(10), p_enable_stop);
+                continue;
+            }
+
+            _live.fetch_add(1, std::memory_order_relaxed);
+            spawn(serve(std::move(*r), spread), _stop);
+        }
+
+        aerror_code e;
+        _acceptor.get(i).close(e);
+
+        _live.fetch_sub(1, std::memory_order_release);
+    }
+
+public:
+    template<class H>
+    http_server(ioc_pool& iocs, H&& h) : _handler{std::forward<H>(h)}, _acceptor{iocs} {}
+
+    ~http_server()
+    {
+        BOOST_ASSERT(_live.load() == 0);
+    }
+
+    http_server(http_server const&) = delete;
+    http_server& operator=(http_server const&) = delete;
+
+    void set_body_limit(_B_<size_t> n) noexcept { _bodyLimit = n; }
+    // initial size of per-connection arena, the arena grows when a request doesn't fit in
+    void set_arena_init_size(_B_<size_t> n) noexcept { BOOST_ASSERT(n.count() > 0); _arenaInitSize = n.count(); }
+    void set_read_timeout      (duration d) noexcept { _readTimeout      = d; }
+    void set_keep_alive_timeout(duration d) noexcept { _keepAliveTimeout = d; }
+    void set_write_timeout     (duration d) noexcept { _writeTimeout     = d; }
+    // how long to wait for in-flight requests when stopped
+    void set_drain_timeout     (duration d) noexcept { _drainTimeout     = d; }
+
+    // opens one listener per io_context with SO_REUSEPORT if available,
+    // otherwise a single listener which distributes connections to io_contexts round robin.
+    aresult<> listen(asio::ip::tcp::endpoint const& ep, int backlog = asio::socket_base::max_listen_connections)
+    {
+        return _acceptor.listen(ep, backlog);
+    }
+
+    // e.g.: for steering connections
+    acceptor_type& acceptor() noexcept { return _acceptor; }
+
+    // the bound address, e.g.: to get the port chosen when listening on port 0, which is shared by all listeners.
+    asio::ip::tcp::endpoint local_endpoint() const
+    {
+        return _acceptor.local_endpoint();
+    }
+
+    // serves until stop requested, then stops accepting and waits for in-flight requests up to drain timeout,
+    // after which connections still alive are closed, returns when all of them finished.
+    // NOTE: a handler which never returns blocks this forever, since it can't be interrupted.
+    atask<> run()
+    {
+        BOOST_ASSERT(_acceptor.size());
+
+        _stop  = std::stop_source{};
+        _abort = std::stop_source{};
+
+        for(size_t i = 0; i < _acceptor.size(); ++i)
+        {
+            _live.fetch_add(1, std::memory_order_relaxed);
+            spawn(accept_loop(i), _stop);
+        }
+
+        steady_timer t(_acceptor.get(0).get_executor());
+
+        co_await t.wait_until(steady_timer::time_point::max(), p_enable_stop);
+
+        // drain
+        _stop.request_stop();
+
+        for(auto deadline = std::chrono::steady_clock::now() + _drainTimeout;
+            _live.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline;)
+        {
+            co_await t.wait(std::chrono::milliseconds(20));
+        }
+
+        // connections still hold this, close them and wait until they all finish
+        if(size_t n = _live.load(std::memory_order_acquire))
+        {
+            JKL_WARN << "http_server: closing " << n << " connections still alive after drain timeout";
+
+            _abort.request_stop();
+
+            while(_live.load(std::memory_order_acquire))
+                co_await t.wait(std::chrono::milliseconds(20));
+        }
+    }
+};
+
+template<class H>
+http_server(ioc_pool&, H&&) -> http_server<std::remove_cvref_t<H>>;
+
+
+} // namespace jkl
@@ -55,15 +55,54 @@ inline auto default_ioc_excep_handler(char const* rp)
 }
 
 
+// asio selects its I/O backend at compile time, for all io_context, see ${PROJECT_NAME}_USE_IO_URING in CMakeLists.txt:
+//   BOOST_ASIO_HAS_IO_URING: files(asio::random_access_file, asio::stream_file) use io_uring, sockets use epoll.
+//   BOOST_ASIO_HAS_IO_URING + BOOST_ASIO_DISABLE_EPOLL: sockets use io_uring too.
+// NOTE: with io_uring, constructing io_context throws if the kernel doesn't support it or it's blocked(e.g.: by seccomp).
+#if defined(BOOST_ASIO_HAS_IO_URING)
+inline constexpr bool ioc_file_io_uring = true;
+#else
+inline constexpr bool ioc_file_io_uring = false;
+#endif
+
+#if defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+inline constexpr bool ioc_socket_io_uring = true;
+#else
+inline constexpr bool ioc_socket_io_uring = false;
+#endif
+
+// e.g.: for logging and benchmark
+constexpr char const* ioc_backend_name() noexcept
+{
+    if constexpr(ioc_socket_io_uring)
+        return "io_uring";
+    else if constexpr(ioc_file_io_uring)
+        return "reactor + io_uring files";
+    else
+        return "reactor";
+}
+
+// concurrency hint for an io_context run by a single thread, which skips locking of I/O objects in the backend.
+// posting to it from other threads is still fine.
+// NOTE: sockets/files of the io_context must only be used on its thread.
+inline constexpr int ioc_single_thread_hint = BOOST_ASIO_CONCURRENCY_HINT_UNSAFE_IO;
+
+
 // single io_context runs in / manages a set of threads
 class mt_ioc_src
 {
 protected:
+    int              _hint;
     asio::io_context _ioc;
     std::optional<asio::executor_work_guard<asio::io_context::executor_type>> _wg;
     std::deque<std::thread> _threads;
 
 public:
+    // concurrencyHint: see ioc_single_thread_hint
+    explicit mt_ioc_src(int concurrencyHint = BOOST_ASIO_CONCURRENCY_HINT_DEFAULT)
+        : _hint{concurrencyHint}, _ioc{concurrencyHint}
+    {}
+
     ~mt_ioc_src()
     {
         join();
@@ -79,6 +118,7 @@ public:
     {
         BOOST_ASSERT(! _wg);
         BOOST_ASSERT(_threads.empty());
+        BOOST_ASSERT(threads <= 1 || _hint != ioc_single_thread_hint);
         
         _ioc.restart();
         _wg.emplace(_ioc.get_executor());
@@ -172,11 +212,19 @@ public:
 // NOTE: handlers could be dispatched to any thread binded to it's io_context
 class ioc_pool
 {
-    std::vector<mt_ioc_src> _srcs;
-    std::atomic_size_t      _next = ATOMIC_VAR_INIT(0);
+    std::deque<mt_ioc_src> _srcs;
+    std::atomic_size_t     _next = ATOMIC_VAR_INIT(0);
 
 public:
-    explicit ioc_pool(size_t n) : _srcs(n) { BOOST_ASSERT(n >= 1); }
+    // concurrencyHint: for each io_context, e.g.: ioc_single_thread_hint when starting with n threads,
+    //                  which is the fastest setup with io_uring.
+    explicit ioc_pool(size_t n, int concurrencyHint = BOOST_ASIO_CONCURRENCY_HINT_DEFAULT)
+    {
+        BOOST_ASSERT(n >= 1);
+
+        for(size_t i = 0; i < n; ++i)
+            _srcs.emplace_back(concurrencyHint);
+    }
 
     size_t ioc_cnt() const noexcept { return _srcs.size(); }
 
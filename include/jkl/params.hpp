@@ -33,4 +33,14 @@ inline constexpr auto p_skip_frag = [](t_skip_frag_t){ return  true; };
 inline constexpr auto p_keep_frag = [](t_skip_frag_t){ return false; };
 
 
+// delay between connection attempts of happy_eyeballs_connect()
+inline constexpr struct t_attempt_delay_t{} t_attempt_delay;
+inline constexpr auto p_attempt_delay = [](auto const& dur) noexcept { return [dur](t_attempt_delay_t){ return dur; }; };
+
+
+// executor to resume the caller on, for operations which may complete on other threads, e.g.: dns_cache::resolve()
+inline constexpr struct t_resume_on_t{} t_resume_on;
+inline constexpr auto p_resume_on = [](auto const& ex) noexcept { return [ex](t_resume_on_t){ return ex; }; };
+
+
 } // namespace jkl
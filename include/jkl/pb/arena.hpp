@@ -0,0 +1,100 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <memory_resource>
+
+
+namespace jkl{
+
+
+namespace detail{
+inline thread_local std::pmr::memory_resource* pb_cur_arena = nullptr;
+} // namespace detail
+
+
+// arena for values decoded by the pb DSL:
+// while reading with it(full_read(b, d, arena) or a pb_arena_scope), every std::pmr container/string the read path fills,
+// e.g.: std::pmr::string, std::pmr::vector<point_t>, even as a member of a plain struct, is made to allocate from it,
+// so decoding a message of many repeated strings/messages costs a few bump allocations,
+// and the whole decoded object graph is freed in one shot by release().
+// values read with the arena must be destroyed before release(), their deallocations are no-ops.
+// typical usage:
+//    pb_arena arena;
+//    for(;;)
+//    {
+//        {
+//            msg_t d; // with std::pmr members
+//            JKL_TRY(Msg.full_read(buf, d, arena));
+//            ...
+//        }
+//        arena.release();
+//    }
+class pb_arena
+{
+    std::unique_ptr<std::byte[]>        _initBuf;
+    std::pmr::monotonic_buffer_resource _res;
+
+public:
+    explicit pb_arena(size_t initSize = 4096,
+                      std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : _initBuf{new std::byte[initSize]}, _res{_initBuf.get(), initSize, upstream}
+    {}
+
+    pb_arena(pb_arena const&) = delete;
+    pb_arena& operator=(pb_arena const&) = delete;
+
+    std::pmr::memory_resource* resource() noexcept { return &_res; }
+
+    // frees all allocations, keeps the initial buffer for reuse
+    void release() noexcept { _res.release(); }
+};
+
+
+// reads on current thread allocate from r during the scope
+class pb_arena_scope
+{
+    std::pmr::memory_resource* _prev;
+
+public:
+    explicit pb_arena_scope(std::pmr::memory_resource* r) noexcept
+        : _prev{std::exchange(detail::pb_cur_arena, r)}
+    {}
+
+    explicit pb_arena_scope(pb_arena& a) noexcept
+        : pb_arena_scope{a.resource()}
+    {}
+
+    pb_arena_scope(pb_arena_scope const&) = delete;
+    pb_arena_scope& operator=(pb_arena_scope const&) = delete;
+
+    ~pb_arena_scope()
+    {
+        detail::pb_cur_arena = _prev;
+    }
+};
+
+
+// before v is filled by the read path: if v is a std::pmr container/string not using the current arena,
+// it's rebuilt with the arena, elements already in it are moved over.
+// no-op for other types, or if there is no current arena.
+template<class V>
+void pb_use_cur_arena(V& v)
+{
+    if constexpr(requires{ v.get_allocator().resource(); })
+    {
+        auto* r = detail::pb_cur_arena;
+
+        if(r && v.get_allocator().resource() != r)
+        {
+            V t(std::move(v), typename V::allocator_type(r));
+            std::destroy_at(&v);
+            std::construct_at(&v, std::move(t));
+        }
+    }
+}
+
+
+} // namespace jkl
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <jkl/util/buf.hpp>
+#include <jkl/pb/varint.hpp>
+#include <span>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+
+namespace jkl{
+
+
+// output of pb_fld::write(chain, d): a chain of fixed size blocks, so a message is written in one pass,
+// without sizing it first or a contiguous buffer of the whole message.
+// length prefixes of nested messages and packed fields are back-patched:
+// 5 bytes are reserved for each length, if the content ends up in the same block, it's moved to follow the minimal
+// length varint, otherwise the length is written as a padded varint(e.g.: 0x83 0x80 0x80 0x80 0x00 for 3),
+// which is valid on wire, but larger than what write(buf, d) produces.
+// blocks are allocated by Alloc, e.g.: read_buf_pool_alloc<uint8_t> to pool them.
+// typical usage:
+//    pb_chain_buf<> c;
+//    Msg.write(c, d);
+//    co_await write_all(conn, c.buffers<asio::const_buffer>()); // gathered into writev
+template<class Alloc = std::allocator<uint8_t>>
+class pb_chain_buf
+{
+public:
+    static constexpr size_t default_block_size = 64 * 1024;
+
+    // a reserved length prefix
+    struct len_slot
+    {
+        uint8_t* p   = nullptr;
+        size_t   pos = 0; // byte_size() after the reserved bytes
+        size_t   blk = 0;
+    };
+
+private:
+    struct block
+    {
+        uint8_t* data;
+        size_t   size; // used, only updated when the block is finished
+        size_t   cap;
+    };
+
+    using alloc_traits = std::allocator_traits<Alloc>;
+
+    [[no_unique_address]] Alloc _alloc;
+    size_t             _blockSize;
+    std::vector<block> _blks;
+    size_t             _done = 0; // bytes in finished blocks
+    uint8_t*           _cur  = nullptr;
+    uint8_t*           _end  = nullptr;
+
+    void finish_last() noexcept
+    {
+        if(_blks.size())
+        {
+            auto& l = _blks.back();
+            l.size = static_cast<size_t>(_cur - l.data);
+            _done += l.size;
+        }
+    }
+
+    void new_block(size_t n)
+    {
+        size_t cap = (std::max)(n, _blockSize);
+
+        _blks.reserve(_blks.size() + 1);
+        uint8_t* p = alloc_traits::allocate(_alloc, cap);
+
+        finish_last();
+        _blks.push_back(block{p, 0, cap});
+        _cur = p;
+        _end = p + cap;
+    }
+
+    void free_blocks() noexcept
+    {
+        for(auto& b : _blks)
+            alloc_traits::deallocate(_alloc, b.data, b.cap);
+        _blks.clear();
+    }
+
+public:
+    explicit pb_chain_buf(size_t blockSize = default_block_size, Alloc const& a = Alloc{})
+        : _alloc{a}, _blockSize{(std::max)(blockSize, size_t(64))}
+    {}
+
+    pb_chain_buf(pb_chain_buf&& r) noexcept
+        : _alloc{r._alloc}, _blockSize{r._blockSize}, _blks{std::move(r._blks)},
+          _done{std::exchange(r._done, 0)}, _cur{std::exchange(r._cur, nullptr)}, _end{std::exchange(r._end, nullptr)}
+    {}
+
+    pb_chain_buf& operator=(pb_chain_buf&& r) noexcept
+    {
+        if(this != &r)
+        {
+            free_blocks();
+            _alloc     = r._alloc;
+            _blockSize = r._blockSize;
+            _blks      = std::move(r._blks);
+            _done      = std::exchange(r._done, 0);
+            _cur       = std::exchange(r._cur, nullptr);
+            _end       = std::exchange(r._end, nullptr);
+        }
+        return *this;
+    }
+
+    ~pb_chain_buf()
+    {
+        free_blocks();
+    }
+
+    // drops content, the first block is kept for reuse
+    void clear() noexcept
+    {
+        if(_blks.size())
+        {
+            block f = _blks.front();
+            _blks.erase(_blks.begin());
+            free_blocks();
+            _blks.push_back(block{f.data, 0, f.cap});
+            _cur = f.data;
+            _end = f.data + f.cap;
+        }
+
+        _done = 0;
+    }
+
+    size_t byte_size() const noexcept
+    {
+        return _done + (_blks.size() ? static_cast<size_t>(_cur - _blks.back().data) : 0);
+    }
+
+    bool empty() const noexcept { return byte_size() == 0; }
+
+    // at least n contiguous bytes to write, then commit() the end of written bytes.
+    uint8_t* prepare(size_t n)
+    {
+        if(static_cast<size_t>(_end - _cur) < n)
+            new_block(n);
+        return _cur;
+    }
+
+    void commit(uint8_t* e) noexcept
+    {
+        BOOST_ASSERT(_cur <= e && e <= _end);
+        _cur = e;
+    }
+
+    void append(void const* p, size_t n)
+    {
+        auto* s = static_cast<uint8_t const*>(p);
+
+        while(n)
+        {
+            if(_cur == _end)
+                new_block(0);
+
+            size_t k = (std::min)(n, static_cast<size_t>(_end - _cur));
+            memcpy(_cur, s, k);
+            _cur += k;
+            s    += k;
+            n    -= k;
+        }
+    }
+
+    len_slot begin_len()
+    {
+        constexpr size_t maxLen = max_varint_wire_size<pb_size_t>;
+
+        uint8_t* p = prepare(maxLen);
+        commit(p + maxLen);
+        return {p, byte_size(), _blks.size() - 1};
+    }
+
+    void end_len(len_slot const& s) noexcept
+    {
+        constexpr size_t maxLen = max_varint_wire_size<pb_size_t>;
+
+        auto const len = static_cast<pb_size_t>(byte_size() - s.pos);
+
+        if(s.blk + 1 == _blks.size())
+        {
+            uint8_t* e = append_varint(s.p, len);
+
+            if(size_t const gap = static_cast<size_t>(s.p + maxLen - e))
+            {
+                memmove(e, s.p + maxLen, len);
+                _cur -= gap;
+            }
+        }
+        else
+        {
+            pb_size_t u = len;
+            for(size_t i = 0; i < maxLen - 1; ++i, u >>= 7)
+                s.p[i] = static_cast<uint8_t>(u | 0x80);
+            s.p[maxLen - 1] = static_cast<uint8_t>(u);
+        }
+    }
+
+    size_t block_cnt() const noexcept { return _blks.size(); }
+
+    std::span<uint8_t const> block_at(size_t i) const noexcept
+    {
+        BOOST_ASSERT(i < _blks.size());
+
+        if(i + 1 == _blks.size())
+            return {_blks[i].data, static_cast<size_t>(_cur - _blks[i].data)};
+        return {_blks[i].data, _blks[i].size};
+    }
+
+    // e.g.: buffers<asio::const_buffer>()
+    template<class Buf>
+    std::vector<Buf> buffers() const
+    {
+        std::vector<Buf> v;
+        v.reserve(_blks.size());
+
+        for(size_t i = 0; i < _blks.size(); ++i)
+        {
+            auto b = block_at(i);
+            if(b.size())
+                v.emplace_back(b.data(), b.size());
+        }
+
+        return v;
+    }
+
+    void copy_to(_resizable_byte_buf_ auto& b) const
+    {
+        for(size_t i = 0; i < _blks.size(); ++i)
+        {
+            auto s = block_at(i);
+            if(s.size())
+                memcpy(buy_buf(b, s.size()), s.data(), s.size());
+        }
+    }
+};
+
+
+template<class T>
+concept _pb_chain_buf_ = requires(T& c, uint8_t* p){ c.prepare(size_t(1)); c.commit(p); c.begin_len(); };
+
+
+} // namespace jkl
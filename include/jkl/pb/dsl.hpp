@@ -10,6 +10,9 @@
 #include <jkl/pb/type.hpp>
 #include <jkl/pb/error.hpp>
 #include <jkl/pb/varint.hpp>
+#include <jkl/pb/chain.hpp>
+#include <jkl/pb/lazy.hpp>
+#include <jkl/pb/arena.hpp>
 #include <boost/mp11/list.hpp>
 #include <boost/mp11/algorithm.hpp>
 #include <boost/preprocessor/repetition/repeat.hpp>
@@ -22,14 +25,14 @@ namespace jkl{
 //
 // limitations:
 //      enum, embedded message not supported;
-//      repeated field cannot be interleaved;
+//      repeated field of fixed size range(e.g.: array) cannot be interleaved;
 //      merging message(which contains required sub fields) is not supported, so a non repeated message field can only present on wire once;
 //      by default strings are not validated as utf8.
 
 
 using mp11::mp_list, mp11::mp_append, mp11::mp_first, mp11::mp_second, mp11::mp_repeat, mp11::mp_size, mp11::mp_plus,
       mp11::mp_fold, mp11::mp_transform, mp11::mp_transform_q, mp11::mp_unique, mp11::mp_unique_if, mp11::mp_at_c,
-      mp11::mp_all_of,
+      mp11::mp_all_of, mp11::mp_find_if, mp11::mp_count_if,
       mp11::mp_bool, mp11::mp_size_t, mp11::mp_iota;
 
 
@@ -350,6 +353,14 @@ struct pb_fld : Params
         return derived()->template read_impl<false>(beg, end, d);
     }
 
+    // reads the field again, i.e.: it has been read from previous records of the enclosing message,
+    // repeated fields append to what have been read, others are overwritten.
+    template<size_t I, _byte_ B>
+    constexpr aresult<B const*> injected_fld_read_more(B const* beg, B const* end, auto& d) const noexcept
+    {
+        return derived()->template injected_fld_read<I>(beg, end, d);
+    }
+
     constexpr Derived      * derived()       noexcept { return static_cast<Derived*>(this); }
     constexpr Derived const* derived() const noexcept { return static_cast<Derived const*>(this); }
 
@@ -528,6 +539,32 @@ struct pb_fld : Params
         write<LenCacheInitSize, true, false>(b, d);
     }
 
+    // fields without len cache entry, i.e.: varint, fixed and static length ones, are written as a whole,
+    // others override this to write their parts separately.
+    template<bool SkipTag, bool SkipLen>
+    void write_chain_impl(_pb_chain_buf_ auto& c, auto const& d) const
+    {
+        pb_size_t* lc = nullptr;
+        pb_size_t const n = derived()->template wire_size<SkipTag, SkipLen>(d, lc);
+        BOOST_ASSERT(lc == nullptr);
+
+        pb_size_t const* clc = nullptr;
+        c.commit(derived()->template write_impl<SkipTag, SkipLen>(c.prepare(n), d, clc));
+    }
+
+    // writes to a pb_chain_buf in one pass, see pb_chain_buf.
+    template<bool SkipTag = (Id == 0), bool SkipLen = (Id == 0), class D = null_op_t>
+    void write(_pb_chain_buf_ auto& c, D const& d = D{}) const
+    {
+        derived()->template write_chain_impl<SkipTag, SkipLen>(c, d);
+    }
+
+    template<class D = null_op_t>
+    void write_len_prefixed(_pb_chain_buf_ auto& c, D const& d = D{}) const
+    {
+        write<true, false>(c, d);
+    }
+
     template<_byte_ B>
     constexpr aresult<B const*> read_len_prefixed(B const* beg, B const* end, auto& d) const
     {
@@ -555,6 +592,14 @@ struct pb_fld : Params
         return full_read<true, false>(b, d);
     }
 
+    // std::pmr containers/strings of d are allocated from arena, see pb_arena.
+    template<bool SkipTag = (Id == 0), bool SkipLen = (Id == 0)>
+    aresult<> full_read(_byte_buf_ auto const& b, auto& d, pb_arena& arena) const
+    {
+        pb_arena_scope s(arena);
+        return full_read<SkipTag, SkipLen>(b, d);
+    }
+
     constexpr aresult<> full_read_len_prefixed(_byte_buf_ auto const& b) const
     {
         return full_read_len_prefixed(b, null_op);
@@ -589,6 +634,11 @@ struct pb_varint_fld : pb_fld<Type, Name, Id, pb_wt_varint, pb_varint_fld<Type,
 
     static constexpr bool is_optional = Params::is_optional;
 
+    // element values are used as they are, so a packed repeated field of it can be decoded in bulk
+    using varint_type = Tar;
+    static constexpr bool is_bulk_varint = ! std::is_same_v<Tar, bool> && ! is_optional
+                                        && ! Params::has_uval && ! Params::has_validate;
+
 
     _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
     constexpr explicit pb_varint_fld(auto&& params)
@@ -849,7 +899,8 @@ constexpr auto pb_double(auto&&... p) noexcept
 
 
 // wire fmt: tag|len|bytes
-// expected value type: _buf_, _str_
+// expected value type: _buf_, _str_,
+//                      or _pb_bytes_view_(e.g.: std::string_view) which is pointed into the input buffer when read.
 // available params: p_val, p_optional, p_has_val, p_clear_val, p_default, p_check.
 // NOTE: you can use p_optional without using a std::optional<...> value,
 //       in that case, if value is fixed size(like array, read only range),
@@ -879,6 +930,8 @@ struct pb_bytes_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
     {
         if constexpr(Params::is_optional_uval && _resizable_buf_<decltype(Params::uval(d))>)
             clear_buf(Params::uval(d));
+        else if constexpr(Params::is_optional_uval && _pb_bytes_view_<JKL_DECL_NO_CVREF_T(Params::uval(d))>)
+            Params::uval(d) = {};
         else
             Params::clear_val(d);
     }
@@ -962,6 +1015,23 @@ struct pb_bytes_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
         return b;
     }
 
+    template<bool SkipTag, bool SkipLen>
+    void write_chain_impl(_pb_chain_buf_ auto& c, auto const& d) const
+    {
+        static_assert(! SkipTag && ! SkipLen);
+
+        if(has_val(d))
+        {
+            decltype(auto) v = as_buf(const_val(d));
+
+            auto len = static_cast<pb_size_t>(buf_byte_size(v));
+
+            auto* b = base::write_tag(c.prepare(base::f_tag_wire_size + max_varint_wire_size<pb_size_t>));
+            c.commit(append_varint(b, len));
+            c.append(buf_data(v), len);
+        }
+    }
+
     template<bool SkipLen, _byte_ B>
     constexpr aresult<B const*> read_impl(B const* beg, B const* end, auto& d) const
     {
@@ -970,24 +1040,41 @@ struct pb_bytes_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
         pb_size_t len = 0;
         JKL_TRY(beg, read_varint(beg, end, len));
 
+        if(BOOST_UNLIKELY(len > static_cast<size_t>(end - beg)))
+            return pb_err::invalid_length;
+
         auto& v = mutable_val(d);
 
-        if constexpr(_resizable_buf_<decltype(v)>)
+        if constexpr(_pb_bytes_view_<JKL_DECL_NO_CVREF_T(v)>)
         {
+            using elm_ptr = decltype(buf_data(v));
             constexpr auto elmSize = sizeof(*buf_data(v));
 
             if(BOOST_UNLIKELY(len % elmSize != 0))
                 return pb_err::invalid_length;
 
-            resize_buf(v, len / elmSize);
+            v = JKL_DECL_NO_CVREF_T(v)(reinterpret_cast<elm_ptr>(beg), len / elmSize);
         }
         else
         {
-            if(BOOST_UNLIKELY(len != buf_byte_size(v)))
-                return pb_err::invalid_length;
-        }
+            if constexpr(_resizable_buf_<decltype(v)>)
+            {
+                constexpr auto elmSize = sizeof(*buf_data(v));
+
+                if(BOOST_UNLIKELY(len % elmSize != 0))
+                    return pb_err::invalid_length;
+
+                pb_use_cur_arena(v);
+                resize_buf(v, len / elmSize);
+            }
+            else
+            {
+                if(BOOST_UNLIKELY(len != buf_byte_size(v)))
+                    return pb_err::invalid_length;
+            }
 
-        memcpy(buf_data(v), beg, len);
+            memcpy(buf_data(v), beg, len);
+        }
 
         return beg + len;
     }
@@ -1071,6 +1158,25 @@ struct pb_repeated_fld : pb_fld<"repeated " + Fld::f_type, Fld::f_name, Fld::f_i
         return _fld.is_static_len(tr_get<0>(u));
     }
 
+    // packed plain varints in a contiguous resizable range, e.g.: std::vector<int64_t>
+    _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+    static constexpr auto is_bulk_varints(auto const& u) noexcept
+    {
+        if constexpr(requires{ Fld::is_bulk_varint; })
+        {
+            using u_t    = JKL_DECL_NO_CVREF_T(u);
+            using elem_t = JKL_DECL_NO_CVREF_T(*std::begin(u));
+
+            return bool_c<is_packed && Fld::is_bulk_varint
+                          && _buf_<u_t> && _arithmetic_<elem_t>
+                          && (_resizable_buf_<u_t> || __has_resize<u_t>)>;
+        }
+        else
+        {
+            return bool_c<false>;
+        }
+    }
+
     template<bool SkipTag>
     constexpr auto static_len_fld_wire_size(auto const& u) const noexcept
     {
@@ -1218,15 +1324,75 @@ struct pb_repeated_fld : pb_fld<"repeated " + Fld::f_type, Fld::f_name, Fld::f_i
         }
     }
 
-    template<bool SkipLen, _byte_ B>
+    template<bool SkipTag, bool SkipLen>
+    void write_chain_impl(_pb_chain_buf_ auto& c, auto const& d) const
+    {
+        static_assert(! SkipTag && ! SkipLen);
+
+        auto const& u = Params::uval(d);
+
+        if constexpr(is_packed)
+        {
+            c.commit(base::write_tag(c.prepare(base::f_tag_wire_size)));
+
+            if constexpr(JKL_CEVL(is_static_len_fld(u)))
+            {
+                pb_size_t* mlc = nullptr;
+                pb_size_t const packedLen = wire_size<true, true>(d, mlc);
+
+                c.commit(append_varint(c.prepare(max_varint_wire_size<pb_size_t>), packedLen));
+
+                if constexpr(JKL_CEVL(same_as_wire_layout(u)))
+                {
+                    BOOST_ASSERT(buf_byte_size(u) == packedLen);
+                    c.append(buf_data(u), packedLen);
+                }
+                else
+                {
+                    for(auto& e : u)
+                        _fld.template write_chain_impl<true, false>(c, e);
+                }
+            }
+            else
+            {
+                auto slot = c.begin_len();
+
+                for(auto& e : u)
+                    _fld.template write_chain_impl<true, false>(c, e);
+
+                c.end_len(slot);
+            }
+        }
+        else
+        {
+            for(auto& e : u)
+                _fld.template write_chain_impl<false, false>(c, e);
+        }
+    }
+
+    template<size_t I, _byte_ B>
+    constexpr aresult<B const*> injected_fld_read_more(B const* beg, B const* end, auto& d) const noexcept
+    {
+        static_assert(I == 0);
+        return read_impl<false, true>(beg, end, d);
+    }
+
+    // Append: keeps elements already in u, fixed size ranges are always overwritten.
+    template<bool SkipLen, bool Append = false, _byte_ B>
     constexpr aresult<B const*> read_impl(B const* beg, B const* end, auto& d) const
     {
         static_assert(! SkipLen);
 
         auto& u = Params::uval(d);
 
+        pb_use_cur_arena(u);
+
         [[maybe_unused]] pb_size_t packedLen = 0;
         [[maybe_unused]] size_t staticLenFldCnt = 0;
+        [[maybe_unused]] size_t oldSize = 0;
+
+        if constexpr(Append && (__has_clear<decltype(u)> || __has_resize<decltype(u)> || _resizable_buf_<decltype(u)>))
+            oldSize = std::size(u);
 
         if constexpr(is_packed)
         {
@@ -1248,25 +1414,57 @@ struct pb_repeated_fld : pb_fld<"repeated " + Fld::f_type, Fld::f_name, Fld::f_i
 
         using elem_t = JKL_DECL_NO_CVREF_T(*std::begin(u));
 
-        if constexpr(! (is_packed && JKL_CEVL(is_static_len_fld(u)))
+        // read_varints() is only faster for runs of same length varints, see "packed varint decode benchmark",
+        // so it's used when packed varints start with such a run, others are read one by one.
+        [[maybe_unused]] bool bulk = false;
+
+        if constexpr(JKL_CEVL(is_bulk_varints(u)))
+            bulk = starts_with_varint_run(beg, end);
+
+        if(bulk)
+        {
+            if constexpr(JKL_CEVL(is_bulk_varints(u)))
+            {
+                // count first, so u is sized only once
+                size_t cnt = count_varints(beg, end);
+
+                if constexpr(_resizable_buf_<decltype(u)>)
+                    resize_buf(u, oldSize + cnt);
+                else
+                    u.resize(oldSize + cnt);
+
+                JKL_TRY(beg, (read_varints<Fld::zigzag, typename Fld::varint_type>(beg, end, buf_data(u) + oldSize, cnt)));
+
+                if(BOOST_UNLIKELY(beg != end))
+                    return pb_err::invalid_length;
+            }
+        }
+        else if constexpr(! (is_packed && JKL_CEVL(is_static_len_fld(u)))
                      || __has_map_insert_or_assign<decltype(u), elem_t>
                      || __has_set_insert<decltype(u), elem_t>)
         {
             if constexpr(__has_clear<decltype(u)>)
             {
-                u.clear();
+                if constexpr(! Append)
+                    u.clear();
+
+                [[maybe_unused]] bool not1st = false;
 
                 while(beg < end)
                 {
                     if constexpr(! is_packed)
                     {
-                        if(u.size()) // skip first tag, as it has been checked
+                        if(not1st) // skip first tag, as it has been checked
                         {
                             if(auto r = _fld.exam_tag(beg, end))
                                 beg = r.value();
                             else
                                 break;
                         }
+                        else
+                        {
+                            not1st = true;
+                        }
                     }
 
                     if constexpr(__has_map_insert_or_assign<decltype(u), elem_t>)
@@ -1275,15 +1473,16 @@ struct pb_repeated_fld : pb_fld<"repeated " + Fld::f_type, Fld::f_name, Fld::f_i
                         JKL_TRY(beg, _fld.template read_impl<false>(beg, end, e));
                         u.insert_or_assign(std::move(std::get<0>(e)), std::move(std::get<1>(e)));
                     }
-                    else
+                    else if constexpr(__has_set_insert<decltype(u), elem_t>)
                     {
                         elem_t e;
                         JKL_TRY(beg, _fld.template read_impl<false>(beg, end, e));
-
-                        if constexpr(__has_set_insert<decltype(u), elem_t>)
-                            u.insert(std::move(e));
-                        else
-                            u.emplace_back(std::move(e));
+                        u.insert(std::move(e));
+                    }
+                    else
+                    {
+                        // in place, so element of allocator-aware u(e.g.: std::pmr::vector) is constructed with its allocator
+                        JKL_TRY(beg, _fld.template read_impl<false>(beg, end, u.emplace_back()));
                     }
                 }
 
@@ -1294,7 +1493,7 @@ struct pb_repeated_fld : pb_fld<"repeated " + Fld::f_type, Fld::f_name, Fld::f_i
 
                     if constexpr(JKL_CEVL(is_static_len_fld(u)))
                     {
-                        if(BOOST_UNLIKELY(std::size(u) != staticLenFldCnt))
+                        if(BOOST_UNLIKELY(std::size(u) != oldSize + staticLenFldCnt))
                             return pb_err::invalid_length;
                     }
                 }
@@ -1337,11 +1536,11 @@ struct pb_repeated_fld : pb_fld<"repeated " + Fld::f_type, Fld::f_name, Fld::f_i
         {
             if constexpr(_resizable_buf_<decltype(u)>)
             {
-                resize_buf(u, staticLenFldCnt);
+                resize_buf(u, oldSize + staticLenFldCnt);
             }
             else if constexpr(__has_resize<decltype(u)>)
             {
-                u.resize(staticLenFldCnt);
+                u.resize(oldSize + staticLenFldCnt);
             }
             else // u is a fixed size range
             {
@@ -1351,14 +1550,14 @@ struct pb_repeated_fld : pb_fld<"repeated " + Fld::f_type, Fld::f_name, Fld::f_i
 
             if constexpr(JKL_CEVL(same_as_wire_layout(u)))
             {
-                memcpy(buf_data(u), beg, packedLen);
+                memcpy(buf_data(u) + oldSize, beg, packedLen);
                 beg = end;
             }
             else
             {
-                for(auto& e : u)
+                for(auto it = std::next(std::begin(u), static_cast<ptrdiff_t>(oldSize)); it != std::end(u); ++it)
                 {
-                    JKL_TRY(beg, _fld.template read_impl<false>(beg, end, e));
+                    JKL_TRY(beg, _fld.template read_impl<false>(beg, end, *it));
                 }
             }
         }
@@ -1381,8 +1580,157 @@ constexpr auto pb_repeated(auto&& fld, auto&&... p) noexcept
 }
 
 
+// wire fmt: records(tag|value) of unknown fields, as they were read
+// unknown fields of the enclosing message: records of tags not defined in the message are kept when read,
+// and written back as they are, so messages of newer schema versions can be forwarded unchanged.
+// expected value type:
+//      _resizable_byte_buf_(e.g.: string): records are copied into it back to back,
+//      or range of _pb_bytes_view_(e.g.: std::vector<std::span<uint8_t const>>): each record is pointed into
+//      the input buffer, which must outlive it, so don't use it with pb_incremental_reader.
+// available params: p_val.
+// NOTE: at most one in a message, it has no name or id. it's written where it's placed, usually the last.
+template<class Params>
+struct pb_unknown_flds_fld : pb_fld<"unknown", "", 0, pb_wt_len_dlm, pb_unknown_flds_fld<Params>, Params>
+{
+    using base = pb_fld<"unknown", "", 0, pb_wt_len_dlm, pb_unknown_flds_fld<Params>, Params>;
+
+    static_assert(! Params::is_optional_uval
+               && ! Params::has_has_val
+               && ! Params::has_default
+               && ! Params::has_clear_val
+               && ! Params::has_get_mem
+               && ! Params::has_act_mem
+               && ! Params::has_act_mem_idx);
+
+    static constexpr bool is_optional = true;
+
+    // no tag is dispatched to it, see pb_message_fld::read_record()
+    using injected_fld_list = mp_list<>;
+
+    _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+    constexpr explicit pb_unknown_flds_fld(auto&& params)
+        : base{JKL_FORWARD(params)}
+    {}
+
+    template<strlit, uint32_t>
+    constexpr auto rebind(auto&& params) const noexcept
+    {
+        return pb_unknown_flds_fld<JKL_DECL_NO_CVREF_T(params)>{JKL_FORWARD(params)};
+    }
+
+    template<_resizable_byte_buf_ S = string>
+    constexpr S fld_def() const
+    {
+        return S{};
+    }
+
+    _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+    constexpr void clear_val(auto& d) const
+    {
+        auto& u = Params::uval(d);
+
+        if constexpr(_resizable_buf_<decltype(u)>)
+            clear_buf(u);
+        else
+            u.clear();
+    }
+
+    // a record [beg, end) of unknown tag
+    template<_byte_ B>
+    constexpr void add_record(B const* beg, B const* end, auto& d) const
+    {
+        auto& u = Params::uval(d);
+        auto const n = static_cast<size_t>(end - beg);
+
+        if constexpr(_resizable_byte_buf_<decltype(u)>)
+        {
+            memcpy(buy_buf(u, n), beg, n);
+        }
+        else
+        {
+            using elem_t = JKL_DECL_NO_CVREF_T(*std::begin(u));
+            static_assert(_pb_bytes_view_<elem_t> && sizeof(*buf_data(std::declval<elem_t&>())) == 1);
+
+            u.emplace_back(reinterpret_cast<decltype(buf_data(std::declval<elem_t&>()))>(beg), n);
+        }
+    }
+
+    template<bool SkipTag = false, bool SkipLen = false>
+    constexpr pb_size_t wire_size(auto const& d, pb_size_t*&) const noexcept
+    {
+        static_assert(! SkipTag && ! SkipLen);
+
+        auto const& u = Params::uval(d);
+
+        if constexpr(_byte_buf_<decltype(u)>)
+        {
+            return static_cast<pb_size_t>(buf_byte_size(u));
+        }
+        else
+        {
+            pb_size_t n = 0;
+            for(auto const& r : u)
+                n += static_cast<pb_size_t>(buf_byte_size(r));
+            return n;
+        }
+    }
+
+    template<bool SkipTag, bool SkipLen, _byte_ B>
+    constexpr B* write_impl(B* b, auto const& d, pb_size_t const*&) const noexcept
+    {
+        static_assert(! SkipTag && ! SkipLen);
+
+        auto const& u = Params::uval(d);
+
+        if constexpr(_byte_buf_<decltype(u)>)
+        {
+            memcpy(b, buf_data(u), buf_byte_size(u));
+            return b + buf_byte_size(u);
+        }
+        else
+        {
+            for(auto const& r : u)
+            {
+                memcpy(b, buf_data(r), buf_byte_size(r));
+                b += buf_byte_size(r);
+            }
+            return b;
+        }
+    }
+
+    template<bool SkipTag, bool SkipLen>
+    void write_chain_impl(_pb_chain_buf_ auto& c, auto const& d) const
+    {
+        static_assert(! SkipTag && ! SkipLen);
+
+        auto const& u = Params::uval(d);
+
+        if constexpr(_byte_buf_<decltype(u)>)
+        {
+            c.append(buf_data(u), buf_byte_size(u));
+        }
+        else
+        {
+            for(auto const& r : u)
+                c.append(buf_data(r), buf_byte_size(r));
+        }
+    }
+};
+
+constexpr auto pb_unknown_flds(auto&&... p) noexcept
+{
+    return pb_unknown_flds_fld<decltype(make_pb_params(JKL_FORWARD(p)...))>{make_pb_params(JKL_FORWARD(p)...)};
+}
+
+template<class T>
+constexpr bool is_pb_unknown_flds_fld_v = false;
+
+template<class Params>
+constexpr bool is_pb_unknown_flds_fld_v<pb_unknown_flds_fld<Params>> = true;
+
+
 // wire fmt: tag|len|sub_flds...
-// expected value type: struct/class
+// expected value type: struct/class, or pb_lazy<struct/class> which is decoded on access.
 // available params: p_val, p_optional, p_has_val, p_clear_val, p_default, p_check.
 template<strlit Type, strlit Name, uint32_t Id, class Params, class... Flds>
 struct pb_message_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
@@ -1407,6 +1755,14 @@ struct pb_message_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
 
     static_assert(! is_pb_reserved_word(Type));
 
+    template<class Fld>
+    using is_unknown_flds_fld = mp_bool<is_pb_unknown_flds_fld_v<Fld>>;
+
+    static_assert(mp_count_if<mp_list<Flds...>, is_unknown_flds_fld>::value <= 1);
+
+    // index of pb_unknown_flds_fld in Flds, sizeof...(Flds) if none
+    static constexpr size_t unknown_flds_idx = mp_find_if<mp_list<Flds...>, is_unknown_flds_fld>::value;
+
     std::tuple<Flds...> _flds;
 
     _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
@@ -1424,6 +1780,35 @@ struct pb_message_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
         return pb_message_fld<Type, RName, RId, JKL_DECL_NO_CVREF_T(params), Flds...>{JKL_FORWARD(params), _flds};
     }
 
+    template<strlit... Names, class... F>
+    static consteval bool any_fld_named(mp_list<F...>) noexcept
+    {
+        return (... || is_oneof(F::f_name, Names...));
+    }
+
+    // the same message, but only with the sub fields(or oneof fields containing them) of Names,
+    // reading with it skips other fields on wire, they are neither touched nor required.
+    // e.g.: Msg.project<"field1", "field15">().full_read(buf, d)
+    template<strlit... Names>
+    constexpr auto project() const
+    {
+        static_assert(sizeof...(Names));
+        static_assert((... && any_fld_named<Names>(expanded_fld_list{})), "no such field");
+
+        auto projected = std::apply([](auto const&... fld){
+            return std::tuple_cat([&fld]{
+                if constexpr(any_fld_named<Names...>(typename JKL_DECL_NO_CVREF_T(fld)::injected_fld_list{}))
+                    return std::tuple{fld};
+                else
+                    return std::tuple{};
+            }()...);
+        }, _flds);
+
+        return std::apply([this](auto const&... fld){
+            return pb_message_fld<Type, Name, Id, Params, JKL_DECL_NO_CVREF_T(fld)...>{static_cast<Params const&>(*this), fld...};
+        }, projected);
+    }
+
     template<_resizable_byte_buf_ S = string>
     constexpr S msg_def() const
     {
@@ -1434,7 +1819,10 @@ struct pb_message_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
         std::apply(
             [&def](auto&... fld)
             {
-                (... , append_str(def, "    ", fld.template fld_def<S>(), "\n"));
+                (... , [&def](auto const& fd){
+                    if(str_size(fd))
+                        append_str(def, "    ", fd, "\n");
+                }(fld.template fld_def<S>()));
             },
             _flds);
 
@@ -1443,10 +1831,33 @@ struct pb_message_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
         return def;
     }
 
+    template<class V>
+    static constexpr bool is_lazy_val = is_pb_lazy_v<std::remove_cvref_t<V>>;
+
+    // an unparsed pb_lazy, its recorded bytes are written as is
+    _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+    static constexpr bool is_raw_lazy(auto const& v) noexcept
+    {
+        if constexpr(is_lazy_val<decltype(v)>)
+            return ! v.parsed();
+        else
+            return false;
+    }
+
+    // value sub fields are applied to
+    _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+    static constexpr auto const& sub_flds_val(auto const& v) noexcept
+    {
+        if constexpr(is_lazy_val<decltype(v)>)
+            return v.value();
+        else
+            return v;
+    }
+
     _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
     constexpr auto is_static_len([[maybe_unused]] auto const& d) const noexcept
     {
-        if constexpr(! is_optional)
+        if constexpr(! is_optional && ! is_lazy_val<decltype(Params::uval(d))>)
         {
             return std::apply([&v = Params::uval(d)](auto&... fld){
                 return (... && fld.is_static_len(v));
@@ -1469,8 +1880,11 @@ struct pb_message_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
         {
             if(Params::has_val(d))
             {
+                if(is_raw_lazy(Params::const_val(d)))
+                    return static_cast<size_t>(SkipLen ? 0 : 1);
+
                 return (SkipLen ? 0 : 1)
-                    + std::apply([&v = Params::const_val(d)](auto&... fld){
+                    + std::apply([&v = sub_flds_val(Params::const_val(d))](auto&... fld){
                           static_assert(sizeof...(fld));
                           return (... + fld.template len_cache_cnt<false>(v));
                       }, _flds);
@@ -1483,10 +1897,24 @@ struct pb_message_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
     _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
     constexpr auto sub_flds_len(auto const& d, pb_size_t*& lc) const noexcept
     {
-        return std::apply([&lc, &v = Params::const_val(d)](auto&... fld){
-            static_assert(sizeof...(fld));
-            return (... + fld.template wire_size<false, false>(v, lc));
-        }, _flds);
+        if constexpr(is_lazy_val<decltype(Params::const_val(d))>)
+        {
+            auto const& l = Params::const_val(d);
+
+            if(! l.parsed())
+                return static_cast<pb_size_t>(l.bytes().size());
+
+            return static_cast<pb_size_t>(std::apply([&lc, &v = l.value()](auto&... fld){
+                return (... + fld.template wire_size<false, false>(v, lc));
+            }, _flds));
+        }
+        else
+        {
+            return std::apply([&lc, &v = Params::const_val(d)](auto&... fld){
+                static_assert(sizeof...(fld));
+                return (... + fld.template wire_size<false, false>(v, lc));
+            }, _flds);
+        }
     }
 
     template<bool SkipTag = (Id == 0), bool SkipLen = (Id == 0)>
@@ -1541,13 +1969,74 @@ struct pb_message_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
                 b = append_varint(b, *lc++);
         }
 
-        std::apply([&, &v = Params::const_val(d)](auto&... fld) {
+        if constexpr(is_lazy_val<decltype(Params::const_val(d))>)
+        {
+            if(is_raw_lazy(Params::const_val(d)))
+            {
+                auto const s = Params::const_val(d).bytes();
+                memcpy(b, s.data(), s.size());
+                return b + s.size();
+            }
+        }
+
+        std::apply([&, &v = sub_flds_val(Params::const_val(d))](auto&... fld) {
                 (... , (b = fld.template write_impl<false, false>(b, v, lc)));
             }, _flds);
 
         return b;
     }
 
+    template<bool SkipTag, bool SkipLen>
+    void write_chain_impl(_pb_chain_buf_ auto& c, auto const& d) const
+    {
+        static_assert(SkipTag ||  !( SkipTag || SkipLen));
+        static_assert(! (SkipTag && is_optional));
+
+        if constexpr(JKL_CEVL(is_static_len(d)))
+        {
+            base::template write_chain_impl<SkipTag, SkipLen>(c, d);
+        }
+        else
+        {
+            if constexpr(! SkipTag)
+            {
+                if(Params::has_val(d))
+                    c.commit(base::write_tag(c.prepare(base::f_tag_wire_size)));
+                else
+                    return;
+            }
+
+            [[maybe_unused]] decltype(c.begin_len()) slot;
+
+            if constexpr(! SkipLen)
+                slot = c.begin_len();
+
+            auto writeSubFlds = [&](auto const& v)
+            {
+                std::apply([&](auto&... fld) {
+                        (... , fld.template write_chain_impl<false, false>(c, v));
+                    }, _flds);
+            };
+
+            if constexpr(is_lazy_val<decltype(Params::const_val(d))>)
+            {
+                auto const& l = Params::const_val(d);
+
+                if(l.parsed())
+                    writeSubFlds(l.value());
+                else
+                    c.append(l.bytes().data(), l.bytes().size());
+            }
+            else
+            {
+                writeSubFlds(Params::const_val(d));
+            }
+
+            if constexpr(! SkipLen)
+                c.end_len(slot);
+        }
+    }
+
     template<bool SkipLen, _byte_ B>
     constexpr aresult<B const*> read_impl(B const* beg, B const* end, auto& d) const
     {
@@ -1563,50 +2052,94 @@ struct pb_message_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
         }
 
         auto& v = Params::mutable_val(d);
-        std::bitset<sizeof...(Flds)> valBits;
 
-        while(beg < end)
+        if constexpr(is_lazy_val<decltype(v)>)
         {
-            uint32_t tag;
-            JKL_TRY(beg, read_varint(beg, end, tag));
+            static_assert(! SkipLen);
+            v.assign_bytes(beg, static_cast<size_t>(end - beg));
+            return end;
+        }
+        else
+        {
+            val_bits_type valBits;
 
-            if(auto r = read_sub_flds(beg, end, tag, v, valBits))
-            {
-                beg = r.value();
-            }
-            else if(r.error() == pb_err::tag_mismatch)
+            while(beg < end)
             {
-                // no matching tag, skip this field
-                switch(tag & 0x7)
-                {
-                    case pb_wt_varint : { JKL_TRY(beg, skip_varint(beg, end   )); break; }
-                    case pb_wt_fix32  : { JKL_TRY(beg, skip_bytes (beg, end, 4)); break; }
-                    case pb_wt_fix64  : { JKL_TRY(beg, skip_bytes (beg, end, 8)); break; }
-                    case pb_wt_len_dlm:
-                        {
-                            pb_size_t len;
-                            JKL_TRY(beg, read_varint(beg, end, len));
-                            JKL_TRY(beg, skip_bytes(beg, end, len));
-                            break;
-                        }
-                    default:
-                        BOOST_ASSERT(false);
-                }
+                JKL_TRY(beg, read_record(beg, end, v, valBits));
             }
-            else
+
+            if constexpr(! SkipLen)
             {
-                return r;
+                BOOST_ASSERT(beg == end);
             }
+
+            JKL_TRY(exam_sub_flds(v, valBits));
+
+            return beg;
         }
+    }
 
-        if constexpr(! SkipLen)
+    // which sub fields have been read
+    using val_bits_type = std::bitset<sizeof...(Flds)>;
+
+    // reads a record(tag and value) at beg, records of unknown tags are skipped.
+    // v: Params::mutable_val(d)
+    template<_byte_ B>
+    BOOST_FORCEINLINE
+    constexpr aresult<B const*> read_record(B const* beg, B const* end, auto& v, val_bits_type& valBits) const
+    {
+        [[maybe_unused]] B const* recBeg = beg;
+
+        uint32_t tag = 0;
+        JKL_TRY(beg, read_varint(beg, end, tag));
+
+        if(auto r = read_sub_flds(beg, end, tag, v, valBits))
         {
-            BOOST_ASSERT(beg == end);
+            return r;
         }
+        else if(r.error() == pb_err::tag_mismatch)
+        {
+            // no matching tag, skip this field
+            JKL_TRY(auto* recEnd, skip_value(beg, end, tag));
+
+            if constexpr(unknown_flds_idx < sizeof...(Flds))
+            {
+                auto& fld = std::get<unknown_flds_idx>(_flds);
 
-        JKL_TRY(exam_sub_flds(v, valBits));
+                if(! valBits.test(unknown_flds_idx))
+                {
+                    fld.clear_val(v);
+                    valBits.set(unknown_flds_idx);
+                }
 
-        return beg;
+                fld.add_record(recBeg, recEnd, v);
+            }
+
+            return recEnd;
+        }
+        else
+        {
+            return r;
+        }
+    }
+
+    template<_byte_ B>
+    static constexpr aresult<B const*> skip_value(B const* beg, B const* end, uint32_t tag) noexcept
+    {
+        switch(tag & 0x7)
+        {
+            case pb_wt_varint : return skip_varint(beg, end   );
+            case pb_wt_fix32  : return skip_bytes (beg, end, 4);
+            case pb_wt_fix64  : return skip_bytes (beg, end, 8);
+            case pb_wt_len_dlm:
+                {
+                    pb_size_t len = 0;
+                    JKL_TRY(beg, read_varint(beg, end, len));
+                    return skip_bytes(beg, end, len);
+                }
+            default:
+                return pb_err::invalid_wire_type;
+        }
     }
 
     template<_byte_ B>
@@ -1685,11 +2218,15 @@ struct pb_message_fld : pb_fld<Type, Name, Id, pb_wt_len_dlm,
             {                                                                  \
                 using indice = mp_at_c<expanded_fld_indice, I + N>;            \
                                                                                \
-                auto r = std::get<mp_first<indice>::value>(_flds).template     \
-                    injected_fld_read<mp_second<indice>::value>(beg, end, v);  \
+                constexpr auto bit = mp_at_c<expended_val_bits_map, I + N>::value; \
+                auto& fld = std::get<mp_first<indice>::value>(_flds);          \
+                                                                               \
+                auto r = valBits.test(bit)                                     \
+                    ? fld.template injected_fld_read_more<mp_second<indice>::value>(beg, end, v) \
+                    : fld.template injected_fld_read     <mp_second<indice>::value>(beg, end, v);\
                                                                                \
                 if(r)                                                          \
-                    valBits.set(mp_at_c<expended_val_bits_map, I + N>::value); \
+                    valBits.set(bit);                                          \
                 return r;                                                      \
             }                                                                  \
             else                                                               \
@@ -1999,6 +2536,15 @@ struct pb_oneof_fld : pb_fld<"oneof " + Name, "", 0, pb_wt_len_dlm,
         return b; // no fld set
     }
 
+    template<bool SkipTag, bool SkipLen>
+    void write_chain_impl(_pb_chain_buf_ auto& c, auto const& d) const
+    {
+        static_assert(! SkipTag && ! SkipLen);
+
+        if(size_t actIdx = Params::active_member_idx(d))
+            visit(actIdx, d, [&](auto& fld, auto& m) { fld.template write_chain_impl<SkipTag, SkipLen>(c, m); });
+    }
+
     // you can only read oneof field from surrendering message's read()
     //template<bool SkipLen, _byte_ B>
     //constexpr aresult<B const*> read_impl(B const* beg, B const* end, auto& d) const
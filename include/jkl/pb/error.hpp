@@ -19,7 +19,9 @@ enum class pb_err
     invalid_length,
     more_data_than_required,
     validation_failed,
-    required_field_missing
+    required_field_missing,
+    invalid_wire_type,
+    msg_too_large
 };
 
 class pb_err_category : public aerror_category
@@ -53,6 +55,10 @@ public:
                 return "validation failed";
             case static_cast<int>(pb_err::required_field_missing) :
                 return "required field missing";
+            case static_cast<int>(pb_err::invalid_wire_type) :
+                return "invalid wire type";
+            case static_cast<int>(pb_err::msg_too_large) :
+                return "msg too large";
         }
 
         return "undefined";
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <jkl/result.hpp>
+#include <jkl/util/buf.hpp>
+#include <jkl/pb/type.hpp>
+#include <jkl/pb/error.hpp>
+#include <jkl/pb/varint.hpp>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+
+namespace jkl{
+
+
+// resumable reader of a message from chunks of input, e.g.: as they arrive from conn_t::read_some(),
+// so the whole message doesn't need to be buffered before decoding.
+// the message is decoded record by record(a top level field's tag and value), complete records of a chunk are
+// decoded in place, only a record split by chunk boundary is buffered, until the rest of it arrives.
+// so a large message made of many records, e.g.: a long non-packed repeated field, is decoded as it streams in,
+// while a single large record, e.g.: a big nested message or bytes field, is buffered until complete.
+// repeated fields split into several records append to what have been read.
+// NOTE: values pointing into the input, i.e.: _pb_bytes_view_(std::string_view, std::span...) and pb_lazy,
+//       are not supported: they would point into the chunk given to feed() or into the pending record,
+//       both are reused/overwritten by following feed(). use owning values(std::string, std::vector...),
+//       or read the whole message with pb_stream_reader or full_read().
+// LenPrefixed: the message is prefixed by its length(write_len_prefixed()), so the reader knows where it ends,
+//              feed() stops there and done() becomes true, otherwise call finish() at the end of input.
+// maxMsgSize: bounds what may be buffered, feed() fails with pb_err::msg_too_large
+//             if a length prefix or a split record declares more than it.
+// typical usage:
+//    pb_incremental_reader r(Msg, d, true);
+//    while(! r.done())
+//    {
+//        JKL_CO_TRY(n, co_await conn.read_some(buf));
+//        JKL_CO_TRY(used, r.feed(buf.data(), n)); // bytes after used belong to next message
+//    }
+template<class Msg, class D>
+class pb_incremental_reader
+{
+    Msg const& _msg;
+    D&         _d;
+    typename Msg::val_bits_type _valBits;
+    std::vector<uint8_t> _pending;     // a split record, or length prefix
+    uint64_t             _left = UINT64_MAX; // bytes left of the message
+    size_t const         _maxMsgSize;
+    bool const           _lenPrefixed;
+    bool                 _needLen;
+    bool                 _done = false;
+
+    // end of the record at b, nullptr if it's incomplete
+    static aresult<uint8_t const*> record_end(uint8_t const* b, uint8_t const* e) noexcept
+    {
+        uint32_t tag = 0;
+        auto r = read_varint(b, e, tag);
+
+        if(! r)
+        {
+            if(r.error() == pb_err::varint_incomplete)
+                return nullptr;
+            return r;
+        }
+
+        b = *r;
+
+        switch(tag & 0x7)
+        {
+            case pb_wt_varint:
+                if(auto s = skip_varint(b, e); s || s.error() != pb_err::varint_incomplete)
+                    return s;
+                return nullptr;
+            case pb_wt_fix32:
+                return (e - b >= 4) ? b + 4 : nullptr;
+            case pb_wt_fix64:
+                return (e - b >= 8) ? b + 8 : nullptr;
+            case pb_wt_len_dlm:
+                {
+                    pb_size_t len = 0;
+                    auto l = read_varint(b, e, len);
+
+                    if(! l)
+                    {
+                        if(l.error() == pb_err::varint_incomplete)
+                            return nullptr;
+                        return l;
+                    }
+
+                    b = *l;
+                    return (static_cast<size_t>(e - b) >= len) ? b + len : nullptr;
+                }
+            default:
+                return pb_err::invalid_wire_type;
+        }
+    }
+
+    aresult<> read_records(uint8_t const* b, uint8_t const* e)
+    {
+        auto& v = _msg.mutable_val(_d);
+
+        while(b < e)
+        {
+            JKL_TRY(b, _msg.read_record(b, e, v, _valBits));
+        }
+
+        return no_err;
+    }
+
+    // consumes bytes of [b, e) into the length prefix
+    aresult<uint8_t const*> take_len(uint8_t const* b, uint8_t const* e)
+    {
+        while(b < e)
+        {
+            _pending.push_back(*b++);
+
+            if(_pending.back() < 0x80)
+            {
+                pb_size_t len = 0;
+                JKL_TRY(read_varint(_pending.data(), _pending.data() + _pending.size(), len));
+
+                if(len > _maxMsgSize)
+                    return pb_err::msg_too_large;
+
+                _pending.clear();
+                _left    = len;
+                _needLen = false;
+                break;
+            }
+
+            if(_pending.size() >= max_varint_wire_size<pb_size_t>)
+                return pb_err::varint_too_large;
+        }
+
+        return b;
+    }
+
+    // bytes to take into the pending record: the rest of it if its header is complete, otherwise enough for a header
+    size_t pending_need() const noexcept
+    {
+        // tag and value of a varint/fixed field, or tag and length of a length delimited field
+        constexpr size_t headerSize = max_varint_wire_size<uint32_t> + max_varint_wire_size<uint64_t>;
+
+        auto* pb = _pending.data();
+        auto* pe = _pending.data() + _pending.size();
+
+        uint32_t  tag = 0;
+        pb_size_t len = 0;
+
+        if(auto t = read_varint(pb, pe, tag); t && (tag & 0x7) == pb_wt_len_dlm)
+        {
+            if(auto l = read_varint(*t, pe, len))
+                return static_cast<size_t>(*l - pb) + len - _pending.size();
+        }
+
+        return headerSize;
+    }
+
+    // the pending record must not grow beyond _maxMsgSize
+    aresult<> check_pending_need() const noexcept
+    {
+        if(_pending.size() + pending_need() > _maxMsgSize)
+            return pb_err::msg_too_large;
+        return no_err;
+    }
+
+    // consumes bytes of [b, e) into the pending record, decodes it once it's complete
+    aresult<uint8_t const*> complete_pending(uint8_t const* b, uint8_t const* e)
+    {
+        while(b < e)
+        {
+            size_t k = (std::min)(static_cast<size_t>(e - b), pending_need());
+
+            _pending.insert(_pending.end(), b, b + k);
+            b += k;
+
+            JKL_TRY(auto* re, record_end(_pending.data(), _pending.data() + _pending.size()));
+
+            if(re)
+            {
+                // bytes beyond the record belong to next records, they were just taken from [b, e)
+                b -= _pending.data() + _pending.size() - re;
+
+                JKL_TRY(read_records(_pending.data(), re));
+                _pending.clear();
+                break;
+            }
+
+            JKL_TRY(check_pending_need());
+        }
+
+        return b;
+    }
+
+public:
+    static constexpr size_t default_max_msg_size = 64 * 1024 * 1024;
+
+    pb_incremental_reader(Msg const& msg, D& d, bool lenPrefixed = false, size_t maxMsgSize = default_max_msg_size)
+        : _msg{msg}, _d{d}, _maxMsgSize{maxMsgSize}, _lenPrefixed{lenPrefixed}, _needLen{lenPrefixed}
+    {}
+
+    // for next message
+    void reset() noexcept
+    {
+        _valBits.reset();
+        _pending.clear();
+        _left    = UINT64_MAX;
+        _needLen = _lenPrefixed;
+        _done    = false;
+    }
+
+    // the message has been read, only for LenPrefixed
+    bool done() const noexcept { return _done; }
+
+    // bytes buffered for a record split by chunk boundary
+    size_t pending_size() const noexcept { return _pending.size(); }
+
+    // returns bytes used, less than n only when the end of a length prefixed message is reached.
+    aresult<size_t> feed(uint8_t const* b, size_t n)
+    {
+        BOOST_ASSERT(! _done);
+
+        uint8_t const* const b0 = b;
+        uint8_t const* e = b + n;
+
+        if(_needLen)
+        {
+            JKL_TRY(b, take_len(b, e));
+
+            if(_needLen)
+                return n;
+        }
+
+        if(static_cast<uint64_t>(e - b) > _left)
+            e = b + _left;
+
+        uint8_t const* const bodyBeg = b;
+
+        while(b < e)
+        {
+            if(_pending.size())
+            {
+                JKL_TRY(b, complete_pending(b, e));
+            }
+            else
+            {
+                uint8_t const* r = b;
+
+                for(;;)
+                {
+                    JKL_TRY(auto* re, record_end(r, e));
+                    if(! re)
+                        break;
+                    r = re;
+                }
+
+                if(r > b)
+                {
+                    JKL_TRY(read_records(b, r));
+                    b = r;
+                }
+
+                if(b < e)
+                {
+                    _pending.assign(b, e);
+                    b = e;
+                    JKL_TRY(check_pending_need());
+                }
+            }
+        }
+
+        if(_left != UINT64_MAX)
+        {
+            _left -= static_cast<uint64_t>(b - bodyBeg);
+
+            if(_left == 0)
+            {
+                JKL_TRY(finish());
+            }
+        }
+
+        return static_cast<size_t>(b - b0);
+    }
+
+    template<_byte_ B>
+    aresult<size_t> feed(B const* b, size_t n)
+    {
+        return feed(reinterpret_cast<uint8_t const*>(b), n);
+    }
+
+    aresult<size_t> feed(_byte_buf_ auto const& b)
+    {
+        return feed(buf_data(b), buf_byte_size(b));
+    }
+
+    // ends the message, checks required fields, clears optional fields not read.
+    aresult<> finish()
+    {
+        if(_needLen || _pending.size() || (_lenPrefixed && _left))
+            return pb_err::msg_incomplete;
+
+        auto& v = _msg.mutable_val(_d);
+        JKL_TRY(_msg.exam_sub_flds(v, _valBits));
+
+        if constexpr(Msg::has_validate)
+        {
+            JKL_TRY(_msg.validate(_d));
+        }
+
+        _done = true;
+        return no_err;
+    }
+};
+
+
+} // namespace jkl
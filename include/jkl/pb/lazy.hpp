@@ -0,0 +1,111 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <jkl/result.hpp>
+#include <jkl/util/buf.hpp>
+#include <span>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <type_traits>
+
+
+namespace jkl{
+
+
+// non-owning value of bytes/string field, e.g.: std::string_view, std::span<uint8_t const>,
+// reading such field makes it point into the input buffer instead of copying the bytes,
+// so the input buffer must outlive it.
+template<class V>
+concept _pb_bytes_view_ = _buf_<V>
+                       && std::is_const_v<std::remove_pointer_t<decltype(buf_data(std::declval<V&>()))>>
+                       && std::is_constructible_v<V, decltype(buf_data(std::declval<V&>())), size_t>;
+
+
+// value of a message field, which is decoded only when accessed:
+// reading the field just records the encoded bytes(pointing into the input buffer, which must outlive it),
+// get(Msg) decodes them on first call.
+// when written, the recorded bytes are copied as is, unless it has been parsed or assigned a value,
+// which is then encoded.
+// NOTE: if the field occurs more than once in input, the last one wins, instead of being merged.
+// typical usage:
+//    struct outer { pb_lazy<inner> sub; };
+//    JKL_TRY(auto* s, d.sub.get(inner_msg)); // inner_msg: message definition of inner
+template<class T>
+class pb_lazy
+{
+    std::span<uint8_t const> _bytes;
+    std::optional<T>         _val;
+
+public:
+    using value_type = T;
+
+    pb_lazy() = default;
+
+    explicit pb_lazy(T v) : _val{std::move(v)} {}
+
+    pb_lazy& operator=(T v)
+    {
+        _val = std::move(v);
+        return *this;
+    }
+
+    // the encoded message, without tag and length
+    std::span<uint8_t const> bytes() const noexcept { return _bytes; }
+
+    bool parsed() const noexcept { return _val.has_value(); }
+
+    // msg: definition of T, e.g.: pb_message<"inner">(...)
+    aresult<T*> get(auto const& msg)
+    {
+        if(! _val)
+        {
+            T v{};
+            JKL_TRY(msg.full_read(_bytes, v));
+            _val = std::move(v);
+        }
+
+        return &*_val;
+    }
+
+    // only if parsed()
+    T& value() noexcept
+    {
+        BOOST_ASSERT(_val);
+        return *_val;
+    }
+
+    T const& value() const noexcept
+    {
+        BOOST_ASSERT(_val);
+        return *_val;
+    }
+
+    template<class... Args>
+    T& emplace(Args&&... args)
+    {
+        return _val.emplace(JKL_FORWARD(args)...);
+    }
+
+    void assign_bytes(void const* p, size_t n) noexcept
+    {
+        _bytes = {static_cast<uint8_t const*>(p), n};
+        _val.reset();
+    }
+
+    void reset() noexcept
+    {
+        _bytes = {};
+        _val.reset();
+    }
+};
+
+
+template<class T>
+constexpr bool is_pb_lazy_v = false;
+
+template<class T>
+constexpr bool is_pb_lazy_v<pb_lazy<T>> = true;
+
+
+} // namespace jkl
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <jkl/task.hpp>
+#include <jkl/result.hpp>
+#include <jkl/pb/type.hpp>
+#include <jkl/pb/error.hpp>
+#include <jkl/pb/chain.hpp>
+#include <jkl/pb/varint.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+
+namespace jkl{
+
+
+// reads length prefixed messages(write_len_prefixed()) back to back from a conn_t.
+// all messages go through one buffer, each read_some() takes as much as the buffer has room for,
+// so a burst of small messages costs one read for many of them, and a message is decoded in place,
+// without being copied out first. consumed bytes are dropped by moving the rest to the front,
+// when there isn't enough room after them. the buffer grows only for a message larger than it.
+// views(std::string_view, pb_lazy...) read by read() point into the buffer, they are valid until next read().
+// typical usage:
+//    pb_stream_reader r(conn);
+//    for(;;)
+//    {
+//        msg_t d;
+//        JKL_CO_TRY(co_await r.read(Msg, d)); // asio::error::eof when conn is closed between messages
+//        ...
+//    }
+template<class Conn>
+class pb_stream_reader
+{
+    Conn&                _conn;
+    std::vector<uint8_t> _buf;
+    size_t               _beg = 0; // [_beg, _end) of _buf are read but not consumed
+    size_t               _end = 0;
+    size_t               _maxMsgSize;
+
+    // makes room for next message, which needs need bytes from _beg, and at least one more byte to read into
+    void prepare(size_t need)
+    {
+        if(_beg == _end)
+            _beg = _end = 0;
+
+        if(_buf.size() - _beg >= need && _end < _buf.size())
+            return;
+
+        if(_beg)
+        {
+            memmove(_buf.data(), _buf.data() + _beg, _end - _beg);
+            _end -= _beg;
+            _beg  = 0;
+        }
+
+        if(_buf.size() < need || _end == _buf.size())
+            _buf.resize((std::max)(need, _buf.size() * 2));
+    }
+
+public:
+    static constexpr size_t default_buf_size = 64 * 1024;
+    static constexpr size_t default_max_msg_size = 64 * 1024 * 1024;
+
+    explicit pb_stream_reader(Conn& conn, size_t bufSize = default_buf_size, size_t maxMsgSize = default_max_msg_size)
+        : _conn{conn}, _buf((std::max)(bufSize, size_t(64))), _maxMsgSize{maxMsgSize}
+    {}
+
+    auto& conn() noexcept { return _conn; }
+
+    // bytes read from conn but not consumed, i.e.: following messages
+    size_t buffered_size() const noexcept { return _end - _beg; }
+
+    // reads next message into d.
+    // returns asio::error::eof if conn is closed before the message starts, pb_err::msg_incomplete if it's closed midway,
+    // pb_err::msg_too_large if the message is larger than maxMsgSize.
+    // the message is consumed even if decoding it fails, so next read() continues with the following one.
+    template<class Msg, class D, class... P>
+    aresult_task<> read(Msg const& msg, D& d, P... p)
+    {
+        for(;;)
+        {
+            uint8_t const* b = _buf.data() + _beg;
+            uint8_t const* e = _buf.data() + _end;
+
+            size_t need = max_varint_wire_size<pb_size_t>;
+
+            pb_size_t len;
+            auto r = read_varint(b, e, len);
+
+            if(r)
+            {
+                if(len > _maxMsgSize)
+                    co_return pb_err::msg_too_large;
+
+                size_t const prefixSize = static_cast<size_t>(*r - b);
+
+                if(static_cast<size_t>(e - *r) >= len)
+                {
+                    _beg += prefixSize + len;
+                    JKL_CO_TRY(msg.full_read(std::span<uint8_t const>(*r, len), d));
+                    co_return no_err;
+                }
+
+                need = prefixSize + len;
+            }
+            else if(r.error() != pb_err::varint_incomplete)
+            {
+                co_return r.error();
+            }
+
+            prepare(need);
+
+            auto n = co_await _conn.read_some(asio::buffer(_buf.data() + _end, _buf.size() - _end), p...);
+
+            if(! n)
+            {
+                if(n.error() == asio::error::eof && _end > _beg)
+                    co_return pb_err::msg_incomplete;
+                co_return n.error();
+            }
+
+            _end += n.value();
+        }
+    }
+};
+
+
+// writes length prefixed messages to a conn_t, batched:
+// write() encodes the message into a queue, then if no write is in progress, writes the queue out in one write_all(),
+// i.e.: one writev of its blocks; messages queued while it is in progress, e.g.: by other coroutines,
+// are written by it in next round, so under load many messages are coalesced into each writev.
+// so a write() returning success only means the message has been queued or written,
+// the error of a failed write is returned by all following write() and flush().
+// not thread safe, all calls must be made on the same strand.
+// typical usage:
+//    pb_stream_writer w(conn);
+//    JKL_CO_TRY(co_await w.write(Msg, d));
+template<class Conn, class Alloc = std::allocator<uint8_t>>
+class pb_stream_writer
+{
+    Conn&               _conn;
+    pb_chain_buf<Alloc> _queued;  // messages waiting for next round
+    pb_chain_buf<Alloc> _writing; // messages being written
+    aerror_code         _err;
+    bool                _flushing = false;
+
+public:
+    explicit pb_stream_writer(Conn& conn, size_t blockSize = pb_chain_buf<Alloc>::default_block_size, Alloc const& a = Alloc{})
+        : _conn{conn}, _queued{blockSize, a}, _writing{blockSize, a}
+    {}
+
+    auto& conn() noexcept { return _conn; }
+
+    // bytes of messages waiting for next round, can be used for back pressure
+    size_t queued_size() const noexcept { return _queued.byte_size(); }
+
+    bool flushing() const noexcept { return _flushing; }
+
+    // only queues the message, flush() writes it
+    template<class Msg, class D>
+    void enqueue(Msg const& msg, D const& d)
+    {
+        msg.write_len_prefixed(_queued, d);
+    }
+
+    template<class Msg, class D, class... P>
+    aresult_task<> write(Msg const& msg, D const& d, P... p)
+    {
+        if(_err)
+            co_return _err;
+
+        enqueue(msg, d);
+        JKL_CO_TRY(co_await flush(p...));
+        co_return no_err;
+    }
+
+    // writes queued messages, until no more are queued.
+    // returns immediately if a flush is already in progress, which will write them.
+    template<class... P>
+    aresult_task<> flush(P... p)
+    {
+        if(_err)
+            co_return _err;
+
+        if(_flushing)
+            co_return no_err;
+
+        _flushing = true;
+
+        while(! _queued.empty())
+        {
+            std::swap(_queued, _writing);
+
+            auto bufs = _writing.template buffers<asio::const_buffer>();
+            auto r = co_await _conn.write_all(bufs, p...);
+
+            _writing.clear();
+
+            if(! r)
+            {
+                _err = r.error();
+                break;
+            }
+        }
+
+        _flushing = false;
+
+        if(_err)
+            co_return _err;
+        co_return no_err;
+    }
+};
+
+
+} // namespace jkl
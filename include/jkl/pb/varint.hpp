@@ -8,6 +8,11 @@
 #include <jkl/pb/error.hpp>
 #include <bit>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64)
+#   include <immintrin.h>
+#endif
 
 
 namespace jkl{
@@ -364,4 +369,156 @@ constexpr aresult<B const*> skip_varint(B const* beg, B const* end) noexcept
     return reinterpret_cast<B const*>(t);
 }
 
+
+// bulk codec for packed varints, e.g.: repeated int64 [packed=true].
+
+namespace detail{
+
+// bit i is the continuation bit of b[i]
+inline unsigned varint_cont_mask16(uint8_t const* b) noexcept
+{
+#if defined(__SSE2__) || defined(_M_X64)
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(b))));
+#else
+    if constexpr(std::endian::native == std::endian::little)
+    {
+        constexpr uint64_t msbs   = 0x8080808080808080ull;
+        constexpr uint64_t gather = 0x0002040810204081ull; // moves msb of each byte to the top byte
+
+        uint64_t lo, hi;
+        memcpy(&lo, b    , 8);
+        memcpy(&hi, b + 8, 8);
+
+        return static_cast<unsigned>(((lo & msbs) * gather) >> 56)
+            | (static_cast<unsigned>(((hi & msbs) * gather) >> 56) << 8);
+    }
+    else
+    {
+        unsigned m = 0;
+        for(unsigned i = 0; i < 16; ++i)
+            m |= static_cast<unsigned>(b[i] >> 7) << i;
+        return m;
+    }
+#endif
+}
+
+template<bool Zigzag, class T>
+constexpr T decode_varint_1(uint8_t b) noexcept
+{
+    if constexpr(Zigzag)
+        return static_cast<T>(zigzag_decode<true>(static_cast<varint_fast_uint_t<T, Zigzag>>(b)));
+    else
+        return static_cast<T>(b);
+}
+
+template<bool Zigzag, class T>
+constexpr T decode_varint_2(uint8_t const* b) noexcept
+{
+    auto u = static_cast<varint_fast_uint_t<T, Zigzag>>((b[0] & 0x7fu) | (static_cast<unsigned>(b[1]) << 7));
+
+    if constexpr(Zigzag)
+        return static_cast<T>(zigzag_decode<true>(u));
+    else
+        return static_cast<T>(u);
+}
+
+} // namespace detail
+
+
+// counts varints in [b, e), i.e.: bytes without continuation bit, so a trailing incomplete varint is not counted.
+// used to size the destination of read_varints() once.
+inline size_t count_varints(uint8_t const* b, uint8_t const* e) noexcept
+{
+    size_t n = 0;
+
+#if defined(__AVX2__)
+    for(; e - b >= 32; b += 32)
+        n += static_cast<size_t>(32 - std::popcount(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(b))))));
+#endif
+
+    for(; e - b >= 16; b += 16)
+        n += static_cast<size_t>(16 - std::popcount(detail::varint_cont_mask16(b)));
+
+    for(; b < e; ++b)
+        n += (*b < 0x80);
+
+    return n;
+}
+
+template<_byte_ B>
+size_t count_varints(B const* beg, B const* end) noexcept
+{
+    return count_varints(reinterpret_cast<uint8_t const*>(beg), reinterpret_cast<uint8_t const*>(end));
+}
+
+// whether [b, e) starts with 16 bytes of 1 byte varints, or of 2 byte varints,
+// i.e.: the runs read_varints() decodes faster than read_varint() one by one.
+inline bool starts_with_varint_run(uint8_t const* b, uint8_t const* e) noexcept
+{
+    if(e - b < 16)
+        return false;
+
+    unsigned m = detail::varint_cont_mask16(b);
+    return m == 0 || m == 0x5555;
+}
+
+template<_byte_ B>
+bool starts_with_varint_run(B const* beg, B const* end) noexcept
+{
+    return starts_with_varint_run(reinterpret_cast<uint8_t const*>(beg), reinterpret_cast<uint8_t const*>(end));
+}
+
+// decodes n varints of T from [b, e) into out, as static_cast<Out>(T).
+// 16 bytes are classified at once by their continuation bits(Masked-VByte style):
+// runs of 1 byte varints and of 2 byte varints are decoded in simple loops the compiler vectorizes.
+// once a window of mixed lengths is met, the rest goes through read_varint(), since classifying each element
+// again costs more than it saves.
+// returns the end of the n-th varint.
+template<bool Zigzag = false, _varint_<Zigzag> T, class Out>
+aresult<uint8_t const*> read_varints(uint8_t const* b, uint8_t const* e, Out* out, size_t n)
+{
+    Out* const oe = out + n;
+
+    while(e - b >= 16 && out < oe)
+    {
+        unsigned m = detail::varint_cont_mask16(b);
+        size_t   r = static_cast<size_t>(oe - out);
+
+        if(m == 0) // 16 x 1 byte
+        {
+            size_t k = (std::min<size_t>)(16, r);
+            for(size_t i = 0; i < k; ++i)
+                out[i] = static_cast<Out>(detail::decode_varint_1<Zigzag, T>(b[i]));
+            b += k; out += k;
+        }
+        else if(m == 0x5555) // 8 x 2 bytes
+        {
+            size_t k = (std::min<size_t>)(8, r);
+            for(size_t i = 0; i < k; ++i)
+                out[i] = static_cast<Out>(detail::decode_varint_2<Zigzag, T>(b + 2 * i));
+            b += 2 * k; out += k;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    for(; out < oe; ++out)
+    {
+        T t{};
+        JKL_TRY(b, read_varint<Zigzag>(b, e, t));
+        *out = static_cast<Out>(t);
+    }
+
+    return b;
+}
+
+template<bool Zigzag = false, _varint_<Zigzag> T, _byte_ B, class Out>
+aresult<B const*> read_varints(B const* beg, B const* end, Out* out, size_t n)
+{
+    JKL_TRY(uint8_t const* t, (read_varints<Zigzag, T>(reinterpret_cast<uint8_t const*>(beg), reinterpret_cast<uint8_t const*>(end), out, n)));
+    return reinterpret_cast<B const*>(t);
+}
+
 } // namespace jkl
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <jkl/util/unit.hpp>
+#include <boost/beast/core/rate_policy.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+
+
+namespace jkl{
+
+
+// lock-free token bucket, shared by any number of connections on any threads.
+// tokens are refilled lazily by whoever asks for them, no timer or thread is needed.
+// rate: bytes per second, 0 means unlimited.
+// burst: maximum tokens that can be accumulated.
+class token_bucket
+{
+    using clock_type = std::chrono::steady_clock;
+
+    std::atomic<int64_t>  _tokens;
+    std::atomic<int64_t>  _lastNs; // last refill time
+    std::atomic<uint64_t> _rate;
+    std::atomic<uint64_t> _burst;
+    std::atomic<uint32_t> _users = 0;
+    uint64_t _minShare;
+
+    static int64_t now_ns() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+    }
+
+    void refill() noexcept
+    {
+        int64_t now  = now_ns();
+        int64_t last = _lastNs.load(std::memory_order_relaxed);
+
+        // refilling in less than 1ms steps only adds contention
+        if(now - last < 1'000'000)
+            return;
+
+        auto r   = static_cast<double>(rate());
+        auto add = static_cast<int64_t>(static_cast<double>(now - last) * r / 1e9);
+
+        // not a whole token yet at a low rate, the time is kept for next refill
+        if(add <= 0)
+            return;
+
+        // advances only by the time the added tokens account for, the fraction is carried to next refill
+        auto next = (std::min)(now, last + static_cast<int64_t>(static_cast<double>(add) * 1e9 / r));
+
+        // only the winner adds the tokens of [last, next)
+        if(! _lastNs.compare_exchange_strong(last, next, std::memory_order_relaxed))
+            return;
+
+        auto burst = static_cast<int64_t>(_burst.load(std::memory_order_relaxed));
+        auto t     = _tokens.load(std::memory_order_relaxed);
+
+        while(! _tokens.compare_exchange_weak(t, (std::min)(t + add, burst), std::memory_order_relaxed))
+        {}
+    }
+
+public:
+    // minShare: the least a connection may take at once, even if there are more users than tokens,
+    //           so every connection can make progress with large number of connections.
+    explicit token_bucket(_B_<uint64_t> rate, _B_<uint64_t> burst = _B_<uint64_t>(0), _B_<uint64_t> minShare = KiB<uint64_t>(4))
+        : _tokens{0}, _lastNs{now_ns()}, _rate{rate.count()},
+          _burst{burst.count() ? burst.count() : rate.count()}, _minShare{minShare.count()}
+    {
+        _tokens.store(static_cast<int64_t>(_burst.load()), std::memory_order_relaxed);
+    }
+
+    token_bucket(token_bucket const&) = delete;
+    token_bucket& operator=(token_bucket const&) = delete;
+
+    uint64_t rate () const noexcept { return _rate .load(std::memory_order_relaxed); }
+    uint64_t burst() const noexcept { return _burst.load(std::memory_order_relaxed); }
+    bool unlimited() const noexcept { return rate() == 0; }
+
+    // takes effect from next refill
+    void set_rate(_B_<uint64_t> rate, _B_<uint64_t> burst = _B_<uint64_t>(0)) noexcept
+    {
+        _rate .store(rate.count(), std::memory_order_relaxed);
+        _burst.store(burst.count() ? burst.count() : rate.count(), std::memory_order_relaxed);
+    }
+
+    // number of connections sharing this bucket
+    uint32_t users() const noexcept { return _users.load(std::memory_order_relaxed); }
+
+    void add_user   () noexcept { _users.fetch_add(1, std::memory_order_relaxed); }
+    void remove_user() noexcept { _users.fetch_sub(1, std::memory_order_relaxed); }
+
+    int64_t tokens() const noexcept { return _tokens.load(std::memory_order_relaxed); }
+
+    // bytes a single user may transfer now: a fair share of the tokens, i.e.: tokens / users,
+    // but at least minShare if there is any token.
+    size_t available() noexcept
+    {
+        if(unlimited())
+            return SIZE_MAX;
+
+        refill();
+
+        int64_t t = _tokens.load(std::memory_order_relaxed);
+
+        if(t <= 0)
+            return 0;
+
+        uint64_t share = static_cast<uint64_t>(t) / (std::max)(users(), uint32_t(1));
+
+        return static_cast<size_t>((std::min)((std::max)(share, _minShare), static_cast<uint64_t>(t)));
+    }
+
+    // may make tokens negative, since concurrent users may take the same tokens,
+    // the debt is paid by next refills.
+    void consume(size_t n) noexcept
+    {
+        if(! unlimited())
+            _tokens.fetch_sub(static_cast<int64_t>(n), std::memory_order_relaxed);
+    }
+};
+
+
+// read and write bandwidth shared by a group of connections, e.g.: global or per host.
+struct shared_bandwidth
+{
+    token_bucket read;
+    token_bucket write;
+
+    // 0 means unlimited
+    shared_bandwidth(_B_<uint64_t> readRate, _B_<uint64_t> writeRate)
+        : read{readRate}, write{writeRate}
+    {}
+};
+
+
+// beast RatePolicy backed by a shared_bandwidth, so a bandwidth cap is shared by all connections attached to it.
+// unlimited until attached.
+// typical usage:
+//    auto bw = std::make_shared<shared_bandwidth>(MiB<uint64_t>(10), MiB<uint64_t>(1));
+//    http_var_conn_t<shared_rate_policy> conn(...);
+//    conn.rate_policy().attach(bw);
+// or let http_conn_factory attach it: factory.set_bandwidth(bw), factory.set_host_bandwidth("example.com", bw2).
+// NOTE: beast::basic_stream waits for on_timer(), which is called once per second, when no bytes are available,
+//       so a connection throttled to zero resumes within a second.
+class shared_rate_policy
+{
+    friend class beast::rate_policy_access;
+
+    std::shared_ptr<shared_bandwidth> _bw;
+    uint64_t _readBytes  = 0;
+    uint64_t _writeBytes = 0;
+
+    size_t available_read_bytes () noexcept { return _bw ? _bw->read .available() : SIZE_MAX; }
+    size_t available_write_bytes() noexcept { return _bw ? _bw->write.available() : SIZE_MAX; }
+
+    void transfer_read_bytes(size_t n) noexcept
+    {
+        _readBytes += n;
+        if(_bw)
+            _bw->read.consume(n);
+    }
+
+    void transfer_write_bytes(size_t n) noexcept
+    {
+        _writeBytes += n;
+        if(_bw)
+            _bw->write.consume(n);
+    }
+
+    void on_timer() noexcept {} // buckets are refilled lazily
+
+public:
+    shared_rate_policy() = default;
+
+    explicit shared_rate_policy(std::shared_ptr<shared_bandwidth> bw) noexcept
+    {
+        attach(std::move(bw));
+    }
+
+    shared_rate_policy(shared_rate_policy&& r) noexcept
+        : _bw{std::move(r._bw)}, _readBytes{r._readBytes}, _writeBytes{r._writeBytes}
+    {}
+
+    shared_rate_policy& operator=(shared_rate_policy&& r) noexcept
+    {
+        if(this != &r)
+        {
+            detach();
+            _bw = std::move(r._bw);
+            _readBytes  = r._readBytes;
+            _writeBytes = r._writeBytes;
+        }
+        return *this;
+    }
+
+    ~shared_rate_policy()
+    {
+        detach();
+    }
+
+    void attach(std::shared_ptr<shared_bandwidth> bw) noexcept
+    {
+        detach();
+
+        if((_bw = std::move(bw)))
+        {
+            _bw->read .add_user();
+            _bw->write.add_user();
+        }
+    }
+
+    void detach() noexcept
+    {
+        if(_bw)
+        {
+            _bw->read .remove_user();
+            _bw->write.remove_user();
+            _bw.reset();
+        }
+    }
+
+    auto const& bandwidth() const noexcept { return _bw; }
+
+    // bytes transferred by this connection, e.g.: for checking fairness
+    uint64_t read_bytes () const noexcept { return _readBytes ; }
+    uint64_t write_bytes() const noexcept { return _writeBytes; }
+};
+
+
+} // namespace jkl
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <jkl/util/unit.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <bit>
+#include <array>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+
+namespace jkl{
+
+
+// size classed slab pool for read buffers shared by connections.
+// blocks are rounded up to power of 2 between min_block and max_block, larger ones are not retained.
+// freed blocks are kept in per class free lists up to maxRetained bytes in total.
+// also learns a typical buffer size from recent usage, which is used as initial size of new buffers.
+class read_buf_pool
+{
+public:
+    static constexpr size_t min_block_shift = 10; // 1KiB
+    static constexpr size_t max_block_shift = 20; // 1MiB
+    static constexpr size_t min_block = size_t(1) << min_block_shift;
+    static constexpr size_t max_block = size_t(1) << max_block_shift;
+    static constexpr size_t class_cnt = max_block_shift - min_block_shift + 1;
+
+private:
+    struct free_list
+    {
+        std::mutex         mtx;
+        std::vector<void*> blocks;
+    };
+
+    std::array<free_list, class_cnt> _lists;
+    size_t const        _maxRetained;
+    std::atomic<size_t> _retained = 0;
+    std::atomic<size_t> _outstanding = 0; // bytes held by buffers
+    std::atomic<size_t> _avgUsed;
+
+    static size_t class_of(size_t n) noexcept
+    {
+        return std::bit_width((std::max)(n, min_block) - 1) - min_block_shift;
+    }
+
+    static size_t class_size(size_t c) noexcept
+    {
+        return min_block << c;
+    }
+
+public:
+    explicit read_buf_pool(_B_<size_t> maxRetained = MiB<size_t>(64), _B_<size_t> initSize = KiB<size_t>(4))
+        : _maxRetained{maxRetained.count()}, _avgUsed{initSize.count()}
+    {}
+
+    ~read_buf_pool()
+    {
+        trim();
+    }
+
+    read_buf_pool(read_buf_pool const&) = delete;
+    read_buf_pool& operator=(read_buf_pool const&) = delete;
+
+    // n is rounded up to class size, so callers may use the whole block_size(n)
+    static size_t block_size(size_t n) noexcept
+    {
+        return n > max_block ? n : class_size(class_of(n));
+    }
+
+    void* allocate(size_t n)
+    {
+        _outstanding.fetch_add(block_size(n), std::memory_order_relaxed);
+
+        if(n > max_block)
+            return ::operator new(n);
+
+        size_t c = class_of(n);
+        auto&  l = _lists[c];
+
+        {
+            std::lock_guard lg{l.mtx};
+
+            if(l.blocks.size())
+            {
+                void* p = l.blocks.back();
+                l.blocks.pop_back();
+                _retained.fetch_sub(class_size(c), std::memory_order_relaxed);
+                return p;
+            }
+        }
+
+        return ::operator new(class_size(c));
+    }
+
+    void deallocate(void* p, size_t n) noexcept
+    {
+        _outstanding.fetch_sub(block_size(n), std::memory_order_relaxed);
+
+        if(n > max_block)
+        {
+            ::operator delete(p);
+            return;
+        }
+
+        size_t c = class_of(n);
+        size_t s = class_size(c);
+
+        if(_retained.fetch_add(s, std::memory_order_relaxed) + s <= _maxRetained)
+        {
+            auto& l = _lists[c];
+            std::lock_guard lg{l.mtx};
+            try
+            {
+                l.blocks.emplace_back(p);
+                return;
+            }
+            catch(...)
+            {
+            }
+        }
+
+        _retained.fetch_sub(s, std::memory_order_relaxed);
+        ::operator delete(p);
+    }
+
+    // frees all retained blocks
+    void trim() noexcept
+    {
+        for(size_t c = 0; c < class_cnt; ++c)
+        {
+            auto& l = _lists[c];
+            std::lock_guard lg{l.mtx};
+
+            for(void* p : l.blocks)
+                ::operator delete(p);
+
+            _retained.fetch_sub(l.blocks.size() * class_size(c), std::memory_order_relaxed);
+            l.blocks.clear();
+        }
+    }
+
+    // the peak used size of a buffer before it goes idle
+    void record_used(size_t n) noexcept
+    {
+        // exponential moving average with alpha = 1/8, racing updates may lose a sample, which is fine.
+        size_t a = _avgUsed.load(std::memory_order_relaxed);
+        _avgUsed.store(a - a / 8 + n / 8, std::memory_order_relaxed);
+    }
+
+    // initial capacity for a new or reactivated buffer
+    size_t initial_size() const noexcept
+    {
+        return block_size(std::clamp(_avgUsed.load(std::memory_order_relaxed), min_block, max_block));
+    }
+
+    size_t retained_bytes   () const noexcept { return _retained   .load(std::memory_order_relaxed); }
+    size_t outstanding_bytes() const noexcept { return _outstanding.load(std::memory_order_relaxed); }
+};
+
+
+inline read_buf_pool& default_read_buf_pool()
+{
+    static read_buf_pool p;
+    return p;
+}
+
+
+template<class T>
+class read_buf_pool_alloc
+{
+    template<class U> friend class read_buf_pool_alloc;
+
+    read_buf_pool* _p;
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    read_buf_pool_alloc() noexcept : _p{&default_read_buf_pool()} {}
+    explicit read_buf_pool_alloc(read_buf_pool& p) noexcept : _p{&p} {}
+
+    template<class U>
+    read_buf_pool_alloc(read_buf_pool_alloc<U> const& a) noexcept : _p{a._p} {}
+
+    read_buf_pool& pool() const noexcept { return *_p; }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(_p->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        _p->deallocate(p, n * sizeof(T));
+    }
+
+    template<class U>
+    bool operator==(read_buf_pool_alloc<U> const& r) const noexcept { return _p == r._p; }
+};
+
+
+// a drop in replacement of flat_buffer as http_conn_t's ReadBuf, e.g.:
+//    http_conn_t<Stream, Req, Res, pooled_flat_buffer>
+// storage is taken from a read_buf_pool on first prepare(), sized by what the pool learned from recent buffers,
+// and returned by release_if_idle() once all read data is consumed, so idle connections don't pin memory.
+class pooled_flat_buffer
+{
+    using buf_type = beast::basic_flat_buffer<read_buf_pool_alloc<char>>;
+
+    buf_type _b;
+    size_t   _peak = 0;
+
+public:
+    using const_buffers_type   = typename buf_type::const_buffers_type;
+    using mutable_buffers_type = typename buf_type::mutable_buffers_type;
+
+    pooled_flat_buffer() = default;
+
+    explicit pooled_flat_buffer(size_t maxSize, read_buf_pool& p = default_read_buf_pool())
+        : _b(maxSize, read_buf_pool_alloc<char>(p))
+    {}
+
+    explicit pooled_flat_buffer(read_buf_pool& p)
+        : _b(read_buf_pool_alloc<char>(p))
+    {}
+
+    read_buf_pool& pool() const noexcept { return _b.get_allocator().pool(); }
+
+    size_t size    () const noexcept { return _b.size    (); }
+    size_t max_size() const noexcept { return _b.max_size(); }
+    size_t capacity() const noexcept { return _b.capacity(); }
+
+    void max_size(size_t n) noexcept { _b.max_size(n); }
+
+    const_buffers_type data () const noexcept { return _b.data (); }
+    const_buffers_type cdata() const noexcept { return _b.cdata(); }
+    mutable_buffers_type data() noexcept { return _b.data(); }
+
+    mutable_buffers_type prepare(size_t n)
+    {
+        if(_b.capacity() == 0)
+            _b.reserve((std::min)((std::max)(n, pool().initial_size()), max_size()));
+
+        return _b.prepare(n);
+    }
+
+    void commit(size_t n) noexcept
+    {
+        _b.commit(n);
+        _peak = (std::max)(_peak, _b.size());
+    }
+
+    void consume(size_t n) noexcept
+    {
+        _b.consume(n);
+    }
+
+    void clear() noexcept
+    {
+        _b.clear();
+    }
+
+    // returns the storage to the pool if there is no unconsumed data, e.g.: after a response is read and nothing
+    // is pipelined behind it. Returns whether the buffer is idle.
+    bool release_if_idle() noexcept
+    {
+        if(_b.size())
+            return false;
+
+        if(_b.capacity())
+        {
+            pool().record_used(_peak);
+            _peak = 0;
+            _b.shrink_to_fit();
+        }
+
+        return true;
+    }
+};
+
+
+} // namespace jkl
@@ -14,7 +14,7 @@ namespace jkl{
 
 auto read_some(auto& s, _mutable_bufseq_ auto const& b, auto... p)
 {
-    return make_ec_awaiter<size_t>(
+    return make_ec_awaiter<size_t>(get_lowest_layer(get_astream(s)),
         [&, b](auto&& h){ get_astream(s).async_read_some(b, std::move(h)); },
         p...);
 }
@@ -24,15 +24,15 @@ auto read_some(auto& s, B& b, auto... p)
 {
     if constexpr(_resizable_buf_<B>)
     {
-        return make_ec_awaiter_c<size_t>(
+        return make_ec_awaiter_c<size_t>(get_lowest_layer(get_astream(s)),
             [&](auto&& h){ get_astream(s).async_read_some(asio_buf(b), std::move(h)); },
             [&](size_t n){ resize_buf(b, n); },
             p...);
     }
     else
     {
-        return make_ec_awaiter<size_t>(
-            [&](auto&& h){ get_astream(s).async_read_some(b, asio_buf(b), std::move(h)); },
+        return make_ec_awaiter<size_t>(get_lowest_layer(get_astream(s)),
+            [&](auto&& h){ get_astream(s).async_read_some(asio_buf(b), std::move(h)); },
             p...);
     }
 }
@@ -40,7 +40,7 @@ auto read_some(auto& s, B& b, auto... p)
 
 auto read_some_to_tail(auto& s, _resizable_byte_buf_ auto& b, size_t maxSize, auto... p)
 {
-    return make_ec_awaiter_c<size_t>(
+    return make_ec_awaiter_c<size_t>(get_lowest_layer(get_astream(s)),
         [&, maxSize](auto&& h){ get_astream(s).async_read_some(buy_asio_buf(b, maxSize), std::move(h)); },
         [&, maxSize](size_t n){ resize_buf(b, buf_size(b) - maxSize + n); },
         p...);
@@ -49,14 +49,14 @@ auto read_some_to_tail(auto& s, _resizable_byte_buf_ auto& b, size_t maxSize, au
 
 auto write_some(auto& s, _const_bufseq_ auto const& b, auto... p)
 {
-    return make_ec_awaiter<size_t>(
+    return make_ec_awaiter<size_t>(get_lowest_layer(get_astream(s)),
         [&, b](auto&& h){ get_astream(s).async_write_some(b, std::move(h)); },
         p...);
 }
 
 auto write_some(auto& s, _byte_buf_ auto& b, auto... p)
 {
-    return make_ec_awaiter<size_t>(
+    return make_ec_awaiter<size_t>(get_lowest_layer(get_astream(s)),
         [&](auto&& h){ get_astream(s).async_write_some(asio_buf(b), std::move(h)); },
         p...);
 }
@@ -66,15 +66,32 @@ auto write_some_from(auto& s, _byte_buf_ auto& b, size_t pos, auto... p)
 {                                     // ^^^^^ not using auto const&, since const& also passes in prvalue, while we want ref here.    
     BOOST_ASSERT(buf_size(b) > pos);
 
-    return make_ec_awaiter_c<size_t>(
+    return make_ec_awaiter<size_t>(get_lowest_layer(get_astream(s)),
         [&, pos](auto&& h){ get_astream(s).async_write_some(asio::buffer(buf_data(b) + pos, buf_size(b) - pos), std::move(h)); },
         p...);
 }
 
 
+// writes all the buffers of b, multiple buffers are gathered into a single writev/sendmsg when the stream supports it,
+// e.g.: write_all(s, gather_bufs(header, body)), so the body is not copied into the header buffer.
+auto write_all(auto& s, _const_bufseq_ auto const& b, auto... p)
+{
+    return make_ec_awaiter<size_t>(get_lowest_layer(get_astream(s)),
+        [&, b](auto&& h){ asio::async_write(get_astream(s), b, std::move(h)); },
+        p...);
+}
+
+auto write_all(auto& s, _byte_buf_ auto& b, auto... p)
+{
+    return make_ec_awaiter<size_t>(get_lowest_layer(get_astream(s)),
+        [&](auto&& h){ asio::async_write(get_astream(s), asio_buf(b), std::move(h)); },
+        p...);
+}
+
+
 auto read(auto& s, _mutable_bufseq_ auto const& b, auto&& compCond, auto... p)
 {
-    return make_ec_awaiter<size_t>(
+    return make_ec_awaiter<size_t>(get_lowest_layer(get_astream(s)),
         [&, b, compCond = std::forward<decltype(compCond)>(compCond)](auto&& h){
             asio::async_read(get_astream(s), b, compCond, std::move(h));
         },
@@ -83,7 +100,7 @@ auto read(auto& s, _mutable_bufseq_ auto const& b, auto&& compCond, auto... p)
 
 auto read(auto& s, _byte_buf_ auto& b, auto&& compCond, auto... p)
 {
-    return make_ec_awaiter<size_t>(
+    return make_ec_awaiter<size_t>(get_lowest_layer(get_astream(s)),
         [&, compCond = std::forward<decltype(compCond)](auto&& h){
             asio::async_read(get_astream(s), asio_buf(b), compCond, std::move(h));
         },
@@ -97,9 +114,9 @@ auto read_to_fill(auto& s, auto&& b, auto... p)
 
 auto read_to_tail(auto& s, _resizable_byte_buf_ auto& b, size_t size, auto... p)
 {
-    return make_ec_awaiter_c<size_t>(
+    return make_ec_awaiter_c<size_t>(get_lowest_layer(get_astream(s)),
         [&, size](auto&& h){ asio::async_read(get_astream(s), asio::buffer(buy_buf(b, size), size), std::move(h)); },
-        [&, size](size_t n){ resize_buf(b, buf_size() - size + n); },
+        [&, size](size_t n){ resize_buf(b, buf_size(b) - size + n); },
         p...);
 }
 
@@ -110,14 +127,14 @@ auto read_to_tail(auto& s, _resizable_byte_buf_ auto& b, size_t size, auto... p)
 
 auto read_until(auto& s, _dynabuf_v1_or_v2_ auto const& b, auto&& match, auto... p)
 {
-    return make_ec_awaiter<size_t>(
+    return make_ec_awaiter<size_t>(get_lowest_layer(get_astream(s)),
         [&, b, match = std::forward<decltype(match)>(match)](auto&& h){
             asio::async_read_until(get_astream(s), b, match, std::move(h));
         },
         p...);
 }
 
-auto read_until(auto& s, _resizable_byte_buf auto& b, auto&& match, auto... p)
+auto read_until(auto& s, _resizable_byte_buf_ auto& b, auto&& match, auto... p)
 {
     return read_until(s, dynabuf(b), std::forward<decltype(match)>(match), p...);
 }
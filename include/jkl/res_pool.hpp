@@ -14,6 +14,7 @@
 #include <list>
 #include <queue>
 #include <mutex>
+#include <vector>
 #include <functional>
 
 
@@ -328,6 +329,9 @@ private:
     }
 
 public:
+    // argument type of creator: creator(emplacer) -> emplacer(args...)
+    using emplacer = emplace_res_to_unused;
+
     _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
     explicit res_pool(std::mutex& m, size_t cap, auto&& create, auto&& onRecycle, asio::io_context& ioc = default_ioc()) requires(lock_outside)
         : _ioc{ioc}, _mut{m}, _cap{cap}, _creator{JKL_FORWARD(create)}, _onRecycle{JKL_FORWARD(onRecycle)}
@@ -432,6 +436,15 @@ public:
         _unused.clear();
     }
 
+    // calls f(T&) on each unused resource with the pool locked, e.g.: to release stale ones.
+    void for_each_unused(auto&& f) requires(has_res)
+    {
+        std::lock_guard lg{_mut};
+
+        for(auto& t : _unused)
+            f(t);
+    }
+
     void reserve(size_t n)
     {
         std::lock_guard lg{_mut};
@@ -539,7 +552,7 @@ private:
     unordered_node_map<Key, pool_type> _pools;
     asio::io_context* _ioc = nullptr;
     size_t _cap = 0;
-    JKL_LAZY_DEF_MEMBER_IF(has_res, std::function<T()>     , _creator  );
+    JKL_LAZY_DEF_MEMBER_IF(has_res, std::function<void(typename pool_type::emplacer)>, _creator);
     JKL_LAZY_DEF_MEMBER_IF(has_res, std::function<void(T&)>, _onRecycle) = [](auto&){};
 
 public:
@@ -644,6 +657,23 @@ public:
         return add_pool<Lock>(JKL_FORWARD(k), _cap, _creator, _onRecycle, *_ioc);
     }
 
+    // calls f(pool_type&) on each pool, without the map locked, so f can lock the pool.
+    // pools are never removed, so they stay valid.
+    void for_each_pool(auto&& f)
+    {
+        std::vector<pool_type*> ps;
+        {
+            std::lock_guard lg{_mut};
+
+            ps.reserve(_pools.size());
+            for(auto& [k, p] : _pools)
+                ps.emplace_back(&p);
+        }
+
+        for(auto* p : ps)
+            f(*p);
+    }
+
     _JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
     res_holder try_acquire(auto&& k)
     {
@@ -3,9 +3,23 @@
 
 #include <jkl/config.hpp>
 #include <jkl/ioc.hpp>
+#include <jkl/gen.hpp>
+#include <jkl/task.hpp>
+#include <jkl/traits.hpp>
+#include <jkl/params.hpp>
 #include <jkl/ec_awaiter.hpp>
+#include <jkl/util/str.hpp>
+#include <jkl/util/stringify.hpp>
+#include <jkl/util/type_traits.hpp>
 
 #include <boost/asio/ip/basic_resolver.hpp>
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/post.hpp>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <utility>
+#include <optional>
 
 
 namespace jkl{
@@ -68,4 +82,117 @@ public:
 
 
 
+namespace detail{
+
+template<class Item>
+struct resolve_many_state
+{
+    std::mutex              mtx;
+    std::deque<Item>        done;
+    std::coroutine_handle<> waiting; // the generator, when waiting for any lookup
+    asio::any_io_executor   ex;      // the generator is resumed on it if set
+};
+
+template<class Item, class Resolver, class... P>
+atask<> resolve_one(Resolver& rsv, std::shared_ptr<resolve_many_state<Item>> st, string host, string service, P... p)
+{
+    auto r = co_await rsv.resolve(host, service, p...);
+
+    std::coroutine_handle<> w;
+    {
+        std::lock_guard lg{st->mtx};
+        st->done.emplace_back(std::move(host), std::move(r));
+        w = std::exchange(st->waiting, nullptr);
+    }
+
+    if(w)
+    {
+        if(st->ex)
+            asio::post(st->ex, [w]{ w.resume(); });
+        else
+            w.resume();
+    }
+}
+
+} // namespace detail
+
+
+template<class Resolver, class... P>
+using resolve_many_item_t = std::pair<string, await_result_t<decltype(std::declval<Resolver&>().resolve(string(), string(), std::declval<P>()...))>>;
+
+// resolves hosts(a range of strings, which must outlive the returned generator) with at most concurrency
+// lookups in flight, and yields (host, aresult of resolve()) in completion order.
+// rsv: any resolver, e.g.:
+//    ares_resolver: all lookups share its channel, nameservers are tried in order on failure, see set_servers().
+//    dns_cache: results are cached, and lookups of the same host are coalesced.
+// p: params for each lookup, e.g.: p_expires_after(5s).
+//    p_resume_on(ex): the consumer is resumed on ex, defaults to rsv's executor if it has one,
+//    otherwise on the thread which completes the lookup.
+// typical usage:
+//    auto g = resolve_many(cache, hosts, "443", 256);
+//    while(auto r = co_await g.next())
+//    {
+//        auto& [host, eps] = *r;
+//        if(eps) spawn(pool.prewarm(aurl(cat_str("https://", host))));
+//    }
+template<class Resolver, class Hosts, class Service, class... P>
+agen<resolve_many_item_t<Resolver, P...>> resolve_many(Resolver& rsv, Hosts const& hosts, Service service,
+                                                       size_t concurrency, P... p)
+{
+    BOOST_ASSERT(concurrency > 0);
+
+    using item_type = resolve_many_item_t<Resolver, P...>;
+
+    auto st = std::make_shared<detail::resolve_many_state<item_type>>();
+
+    auto pex = make_params(p..., [](t_resume_on_t){ return null_op; })(t_resume_on);
+
+    if constexpr(! is_null_op_v<decltype(pex)>)
+        st->ex = pex;
+    else if constexpr(requires{ rsv.get_executor(); })
+        st->ex = rsv.get_executor();
+
+    auto&& svc = stringify(service);
+    string svcStr(str_data(svc), str_size(svc));
+
+    size_t inflight = 0;
+    auto   it  = std::begin(hosts);
+    auto   end = std::end(hosts);
+
+    for(;;)
+    {
+        for(; inflight < concurrency && it != end; ++it, ++inflight)
+        {
+            auto&& h = stringify(*it);
+            spawn(detail::resolve_one<item_type>(rsv, st, string(str_data(h), str_size(h)), svcStr, p...));
+        }
+
+        if(inflight == 0)
+            break;
+
+        co_await suspend_awaiter([&](auto c)
+        {
+            std::lock_guard lg{st->mtx};
+
+            if(st->done.size())
+                return false;
+
+            st->waiting = c;
+            return true;
+        });
+
+        std::optional<item_type> item;
+        {
+            std::lock_guard lg{st->mtx};
+            BOOST_ASSERT(st->done.size());
+            item.emplace(std::move(st->done.front()));
+            st->done.pop_front();
+        }
+
+        --inflight;
+        co_yield std::move(*item);
+    }
+}
+
+
 } // namespace jkl
\ No newline at end of file
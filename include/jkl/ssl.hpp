@@ -4,15 +4,254 @@
 #include <jkl/tcp.hpp>
 #include <jkl/error.hpp>
 #include <jkl/result.hpp>
+#include <jkl/util/unordered_map_set.hpp>
 #include <boost/asio/ssl/error.hpp>
 #include <boost/asio/ssl/stream.hpp>
 #include <boost/asio/ssl/context.hpp>
 #include <boost/certify/https_verification.hpp>
+#include <list>
+#include <string>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
 
 
 namespace jkl{
 
 
+// client side TLS session cache, per server(SNI hostname:port) and bounded with LRU.
+// sessions are collected via SSL_CTX_sess_set_new_cb(), so TLS 1.3 tickets sent after handshake also work.
+// usage:
+//    ssl_session_cache cache(256);
+//    ssl_ctx.use_session_cache(cache); // cache must outlive ssl_ctx
+//    ... ssl_conn_t::handshake() / http_conn_t::handshake() will try resuming automatically ...
+class ssl_session_cache
+{
+    struct sess_deleter { void operator()(SSL_SESSION* s) noexcept { ::SSL_SESSION_free(s); } };
+    using sess_ptr = std::unique_ptr<SSL_SESSION, sess_deleter>;
+    using lru_list = std::list<std::pair<string, sess_ptr>>;
+
+    std::mutex _mtx;
+    size_t     _cap;
+    lru_list   _lru; // most recently used at front
+    unordered_flat_map<string, lru_list::iterator> _map;
+
+    std::atomic_size_t _hits     = 0; // session found for host before handshake
+    std::atomic_size_t _misses   = 0;
+    std::atomic_size_t _resumed  = 0; // handshakes actually resumed
+    std::atomic_size_t _full     = 0; // full handshakes
+
+    static int ex_data_index()
+    {
+        static int const idx = ::SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+        return idx;
+    }
+
+    // peer port of an SSL, set by try_resume(), stored as the pointer value, so nothing to free
+    static int port_ex_data_index()
+    {
+        static int const idx = ::SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+        return idx;
+    }
+
+    // "hostname:port", same session can't be used for another port, e.g.: different servers behind same name.
+    // empty if no SNI hostname was set.
+    static string key_of(SSL* ssl)
+    {
+        auto* host = ::SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+        if(! host)
+            return {};
+
+        auto port = reinterpret_cast<std::uintptr_t>(::SSL_get_ex_data(ssl, port_ex_data_index()));
+
+        string k(host);
+        k += ':';
+        k += std::to_string(port);
+        return k;
+    }
+
+    static int on_new_session(SSL* ssl, SSL_SESSION* sess) noexcept
+    {
+        auto* c = of(ssl);
+
+        if(! c)
+            return 0;
+
+        // no exception can cross OpenSSL. we keep our own copy and return 0 even on success,
+        // so OpenSSL drops its reference either way, and a throwing put() can't free it twice.
+        // a copy rather than a reference: sess is the connection's current session, which OpenSSL marks
+        // not resumable when the connection is freed without close_notify, as most http clients do.
+        try
+        {
+            auto key = key_of(ssl);
+
+            if(key.size())
+            {
+                if(sess_ptr dup{::SSL_SESSION_dup(sess)})
+                    c->put(key, std::move(dup));
+            }
+        }
+        catch(...)
+        {
+        }
+
+        return 0;
+    }
+
+    void put(string_view key, sess_ptr sess)
+    {
+        std::lock_guard lg{_mtx};
+
+        if(auto it = _map.find(key); it != _map.end())
+        {
+            it->second->second = std::move(sess);
+            _lru.splice(_lru.begin(), _lru, it->second);
+            return;
+        }
+
+        if(_map.size() >= _cap)
+        {
+            _map.erase(_lru.back().first);
+            _lru.pop_back();
+        }
+
+        _lru.emplace_front(key, std::move(sess));
+        _map.emplace(_lru.front().first, _lru.begin());
+    }
+
+    // returns an extra reference, caller should SSL_SESSION_free() it.
+    SSL_SESSION* get1(string_view key)
+    {
+        std::lock_guard lg{_mtx};
+
+        if(auto it = _map.find(key); it != _map.end())
+        {
+            SSL_SESSION* s = it->second->second.get();
+
+            if(::SSL_SESSION_is_resumable(s))
+            {
+                _lru.splice(_lru.begin(), _lru, it->second);
+                ::SSL_SESSION_up_ref(s);
+                return s;
+            }
+
+            _lru.erase(it->second);
+            _map.erase(it);
+        }
+
+        return nullptr;
+    }
+
+public:
+    explicit ssl_session_cache(size_t cap = 256) : _cap{cap}
+    {
+        BOOST_ASSERT(_cap > 0);
+    }
+
+    ssl_session_cache(ssl_session_cache const&) = delete;
+    ssl_session_cache& operator=(ssl_session_cache const&) = delete;
+
+    // the cache attached to ssl's context, if any
+    static ssl_session_cache* of(SSL* ssl) noexcept
+    {
+        return static_cast<ssl_session_cache*>(::SSL_CTX_get_ex_data(::SSL_get_SSL_CTX(ssl), ex_data_index()));
+    }
+
+    void attach(SSL_CTX* ctx)
+    {
+        if(! ::SSL_CTX_set_ex_data(ctx, ex_data_index(), this))
+            throw asystem_error(aerror_code(static_cast<int>(::ERR_get_error()), asio::error::get_ssl_category()));
+
+        ::SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        ::SSL_CTX_sess_set_new_cb(ctx, &on_new_session);
+    }
+
+    // set cached session of SNI hostname and port to ssl, if any.
+    // port: of the server, sessions received on ssl are cached under it too.
+    // should be called after SNI hostname was set and before client handshake.
+    static void try_resume(SSL* ssl, uint16_t port) noexcept
+    {
+        auto* c = of(ssl);
+        if(! c)
+            return;
+
+        ::SSL_set_ex_data(ssl, port_ex_data_index(), reinterpret_cast<void*>(static_cast<std::uintptr_t>(port)));
+
+        string key;
+
+        try
+        {
+            key = key_of(ssl);
+        }
+        catch(...)
+        {
+            return;
+        }
+
+        if(key.empty())
+            return;
+
+        if(SSL_SESSION* s = c->get1(key))
+        {
+            ::SSL_set_session(ssl, s); // SSL_set_session() takes its own reference
+            ::SSL_SESSION_free(s);
+            c->_hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            c->_misses.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // should be called after a successful client handshake
+    static void on_handshake_done(SSL* ssl) noexcept
+    {
+        if(auto* c = of(ssl))
+        {
+            if(::SSL_session_reused(ssl))
+                c->_resumed.fetch_add(1, std::memory_order_relaxed);
+            else
+                c->_full.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    size_t size()
+    {
+        std::lock_guard lg{_mtx};
+        return _map.size();
+    }
+
+    void clear()
+    {
+        std::lock_guard lg{_mtx};
+        _map.clear();
+        _lru.clear();
+    }
+
+    size_t hits           () const noexcept { return _hits   .load(std::memory_order_relaxed); }
+    size_t misses         () const noexcept { return _misses .load(std::memory_order_relaxed); }
+    size_t resumed        () const noexcept { return _resumed.load(std::memory_order_relaxed); }
+    size_t full_handshakes() const noexcept { return _full   .load(std::memory_order_relaxed); }
+
+    double hit_rate() const noexcept
+    {
+        size_t h = hits(), t = h + misses();
+        return t ? static_cast<double>(h) / static_cast<double>(t) : 0.0;
+    }
+
+    double resume_rate() const noexcept
+    {
+        size_t r = resumed(), t = r + full_handshakes();
+        return t ? static_cast<double>(r) / static_cast<double>(t) : 0.0;
+    }
+
+    void reset_counters() noexcept
+    {
+        _hits = 0; _misses = 0; _resumed = 0; _full = 0;
+    }
+};
+
+
 class ssl_context : public asio::ssl::context
 {
     using base = asio::ssl::context;
@@ -36,6 +275,12 @@ public:
     {
         boost::certify::enable_native_https_server_verification(*this);
     }
+
+    // enables client side session resumption, c must outlive this context.
+    void use_session_cache(ssl_session_cache& c)
+    {
+        c.attach(native_handle());
+    }
 };
 
 
@@ -51,6 +296,12 @@ public:
     template<class... P>
     auto handshake(asio::ssl::stream_base::handshake_type t, P... p)
     {
+        if(t == asio::ssl::stream_base::client)
+        {
+            aerror_code e;
+            ssl_session_cache::try_resume(base::stream_native_handle(), base::lowest_layer().remote_endpoint(e).port());
+        }
+
         return make_ec_awaiter(
             [&, t](auto&& h){ base::stream().async_handshake(t, std::move(h)); },
             p...);
@@ -59,6 +310,12 @@ public:
     template<class B, class... P>
     auto buffered_handshake(asio::ssl::stream_base::handshake_type t, B& buf, P... p)
     {
+        if(t == asio::ssl::stream_base::client)
+        {
+            aerror_code e;
+            ssl_session_cache::try_resume(base::stream_native_handle(), base::lowest_layer().remote_endpoint(e).port());
+        }
+
         return make_ec_awaiter(
             [&, t, b = asio_buf(b)](auto&& h){ base::stream().async_handshake(t, b, std::move(h)); },
         p...);
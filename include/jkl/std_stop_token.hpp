@@ -600,6 +600,8 @@ public:
     {
         _p = std::make_unique<stop_cb_type>(st, JKL_FORWARD(f));
     }
+
+    void reset() noexcept { _p.reset(); }
 };
 
 
@@ -7,6 +7,7 @@
 #include <jkl/task.hpp>
 #include <jkl/result.hpp>
 #include <jkl/ec_awaiter.hpp>
+#include <jkl/happy_eyeballs.hpp>
 #include <jkl/util/unit.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
@@ -27,6 +28,8 @@ template<class Stream>
 class timed_stream_t
 {
     Stream  _s;
+    // set along with the stream's, which can't be queried, for operations bypassing the stream
+    asio::steady_timer::time_point _expiry = asio::steady_timer::time_point::max();
 
 public:
     using stream_type       = Stream;   // beast::basic_stream, beast::ssl_stream
@@ -64,9 +67,23 @@ public:
 
     void cancel() { next_layer().cancel(); }
     void close () { next_layer().close (); }
-    void expires_after(std::chrono::nanoseconds t) { next_layer().expires_after(t); }
-    void expires_at(asio::steady_timer::time_point t) { next_layer().expires_at(t); }
-    void expires_never() { next_layer().expires_never(); }
+    void expires_after(std::chrono::nanoseconds t)
+    {
+        next_layer().expires_after(t);
+        _expiry = asio::steady_timer::clock_type::now() + std::chrono::duration_cast<asio::steady_timer::duration>(t);
+    }
+
+    void expires_at(asio::steady_timer::time_point t)
+    {
+        next_layer().expires_at(t);
+        _expiry = t;
+    }
+
+    void expires_never()
+    {
+        next_layer().expires_never();
+        _expiry = asio::steady_timer::time_point::max();
+    }
     auto release_socket() { return next_layer().release_socket();}
 
     template<class T>
@@ -120,15 +137,35 @@ public:
 
     template<class... P>
     aresult_task<> connect_url(aurl u, P... p)
+    {
+        tcp_resolver_t<executor_type> rsv(get_executor());
+        co_return co_await connect_url_with(rsv, std::move(u), p...);
+    }
+
+    // resolves with rsv (e.g.: resolver_t, ares_resolver), then races resolved endpoints(happy eyeballs).
+    // the connecting is timed by p_expires_after() in p, or else by expires_after()/expires_at() of this.
+    template<class Resolver, class... P>
+    aresult_task<> connect_url_with(Resolver& rsv, aurl u, P... p)
     {
         if(auto e = u.endpoint())
             co_return co_await connect(*e, p...);
 
-        tcp_resolver_t<executor_type> rsv(get_executor());
-
         JKL_CO_TRY(eps, co_await rsv.resolve(u.hostname(), u.real_port_or_protocol(), p...));
 
-        co_return co_await connect(eps, p...);
+        // happy_eyeballs_connect() works on the socket, which isn't timed by the stream,
+        // so the stream's expiry is passed on, unless p has one.
+        if constexpr(std::is_same_v<decltype(make_params(p..., p_expires_never)(t_expiry_dur)), null_op_t>)
+        {
+            if(_expiry != asio::steady_timer::time_point::max())
+            {
+                auto left = (std::max)(_expiry - asio::steady_timer::clock_type::now(), asio::steady_timer::duration::zero());
+                JKL_CO_TRY(co_await happy_eyeballs_connect(socket(), eps, p..., p_expires_after(left)));
+                co_return no_err;
+            }
+        }
+
+        JKL_CO_TRY(co_await happy_eyeballs_connect(socket(), eps, p...));
+        co_return no_err;
     }
 
     template<class... P>
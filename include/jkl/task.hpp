@@ -380,6 +380,43 @@ template<class T = void>
 using aresult_task = atask<aresult<T>>;
 
 
+// a coroutine that starts eagerly and destroys itself when done, only used by spawn().
+struct _spawned_coro
+{
+    struct promise_type
+    {
+        std::stop_source _stpSrc;
+
+        template<class Task>
+        promise_type(Task&, std::stop_source const& s) noexcept : _stpSrc{s} {}
+
+        std::stop_source const& get_stop_source() const noexcept { return _stpSrc; }
+        std::stop_token get_stop_token() const noexcept { return _stpSrc.get_token(); }
+        bool stop_requested() const noexcept { return _stpSrc.stop_requested(); }
+
+        _spawned_coro get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+template<class Task>
+_spawned_coro _spawn_coro(Task t, std::stop_source const& /*s*/)
+{
+    co_await t;
+}
+
+// start t detached, its frame is destroyed when it finishes.
+// like std::thread, exceptions escaped from t will terminate the program, so t should handle them itself.
+template<class T>
+void spawn(atask<T> t, std::stop_source const& s = std::stop_source{})
+{
+    _spawn_coro(std::move(t), s);
+}
+
+
 
 // post: submit the handle for later execution. The handle may be executed before the caller returns(if there is other
 //       work after ex.post() in caller). The thread pool implementation usually require a lock for enqueue the job
@@ -19,10 +19,12 @@ public:
     using duration   = typename Timer::duration;
     using time_point = typename Timer::time_point;
 
+    using Timer::Timer;
+
     template<class... P>
     auto wait(P... p)
     {
-        return make_ec_awaiter(
+        return make_ec_awaiter<void>(*this,
             [&](auto&& h){ Timer::async_wait(std::move(h)); },
             p...
         );
@@ -32,7 +32,7 @@ decltype(auto) get_next_layer(T&& t)
     if constexpr(requires{ std::forward<T>(t).next_layer(); })
         return std::forward<T>(t).next_layer();
     else
-        return std::forward<T>(t).get_executor();
+        return std::forward<T>(t); // the lowest layer is its own next layer
 }
 
 using beast::get_lowest_layer;
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <jkl/config.hpp>
+#include <jkl/buf.hpp>
+#include <jkl/file.hpp>
+#include <jkl/task.hpp>
+#include <jkl/traits.hpp>
+#include <jkl/result.hpp>
+#include <jkl/ec_awaiter.hpp>
+#include <jkl/read_write.hpp>
+#include <jkl/util/unit.hpp>
+#include <boost/asio/socket_base.hpp>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#if defined(__linux__)
+#   include <cerrno>
+#   include <sys/socket.h>
+#   include <sys/sendfile.h>
+#   include <netinet/in.h>
+#   include <linux/errqueue.h>
+#endif
+
+
+namespace jkl{
+
+
+namespace detail{
+
+// the asio socket under a stream, e.g.: the socket of beast::basic_stream
+_JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+decltype(auto) lowest_socket(auto& s)
+{
+    auto& l = get_lowest_layer(get_astream(s));
+
+    if constexpr(requires{ l.socket(); })
+        return (l.socket());
+    else
+        return (l);
+}
+
+// whether bytes written to the socket reach the peer as they are, i.e.: no TLS in between.
+_JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+bool is_plain_stream(auto& s)
+{
+    auto& a = get_astream(s);
+
+    if constexpr(requires{ a.is_ssl(); })
+        return ! a.is_ssl();
+    else
+        return ! requires{ a.next_layer(); };
+}
+
+_JKL_MSVC_WORKAROUND_TEMPL_FUN_ABBR
+auto wait_socket(auto& s, asio::socket_base::wait_type w, auto... p)
+{
+    return make_ec_awaiter<void>(get_lowest_layer(get_astream(s)),
+        [&, w](auto&& h){ lowest_socket(s).async_wait(w, std::move(h)); },
+        p...);
+}
+
+// sets the socket to non-blocking mode and restores the previous mode on destruction,
+// asio caches the mode, so a socket left in non-blocking mode changes how later sync calls behave.
+template<class Sock>
+class scoped_native_non_blocking
+{
+    Sock& _sock;
+    bool  _prev;
+
+public:
+    scoped_native_non_blocking(Sock& sock, aerror_code& ec)
+        : _sock{sock}, _prev{sock.native_non_blocking()}
+    {
+        if(! _prev)
+            _sock.native_non_blocking(true, ec);
+    }
+
+    ~scoped_native_non_blocking()
+    {
+        if(! _prev)
+        {
+            aerror_code ec;
+            _sock.native_non_blocking(false, ec);
+        }
+    }
+
+    scoped_native_non_blocking(scoped_native_non_blocking const&) = delete;
+    scoped_native_non_blocking& operator=(scoped_native_non_blocking const&) = delete;
+};
+
+template<class S, class... P>
+aresult_task<uint64_t> copy_file_to(S& s, synced_file& f, uint64_t offset, uint64_t n, P... p)
+{
+    JKL_CO_TRY(f.seek(offset));
+
+    size_t const bufSize = static_cast<size_t>((std::min<uint64_t>)(n, KiB<uint64_t>(64).count()));
+    std::unique_ptr<char[]> buf(new char[bufSize]);
+
+    uint64_t sent = 0;
+
+    while(sent < n)
+    {
+        JKL_CO_TRY(size_t r, f.read(buf.get(), static_cast<size_t>((std::min<uint64_t>)(bufSize, n - sent))));
+
+        if(r == 0)
+            break;
+
+        JKL_CO_TRY(co_await write_all(s, asio::buffer(buf.get(), r), p...));
+        sent += r;
+    }
+
+    co_return sent;
+}
+
+// the error queue becoming readable is only signaled by an edge of EPOLLERR, which may come
+// before the wait is registered, so each wait is bounded by this and the queue is polled again.
+inline constexpr auto errqueue_poll_interval = std::chrono::milliseconds(50);
+
+// calls readNotifications() until it returns true, waiting for the error queue of s in between.
+// p_expires_after applies to the whole wait, as if it were a single wait for the socket.
+template<class S, class F, class... P>
+aresult_task<> wait_notifications(S& s, F& readNotifications, P... p)
+{
+    auto const dur = make_params(p..., p_expires_never)(t_expiry_dur);
+    [[maybe_unused]] auto const start = std::chrono::steady_clock::now();
+
+    for(;;)
+    {
+        JKL_CO_TRY(bool got, readNotifications());
+        if(got)
+            co_return no_err;
+
+        if constexpr(! is_null_op_v<decltype(dur)>)
+        {
+            if(std::chrono::steady_clock::now() - start >= dur)
+                co_return gerrc::timeout;
+        }
+
+        auto r = co_await wait_socket(s, asio::socket_base::wait_error, p_expires_after(errqueue_poll_interval), p...);
+
+        if(! r && r.error() != gerrc::timeout)
+            co_return r.error();
+    }
+}
+
+} // namespace detail
+
+
+// sends n bytes of f from offset to s.
+// on linux, plain(non TLS) streams use sendfile(2), so the file content never enters user space,
+// otherwise f is read into a buffer and written to s.
+// returns bytes sent, which is less than n only if the end of f is reached.
+// NOTE: sendfile writes to the socket directly, bypassing timeouts and rate policy of beast::basic_stream,
+//       use p_expires_after/p_enable_stop, which apply to each wait for the socket being writable.
+template<class S, class... P>
+aresult_task<uint64_t> send_file(S& s, synced_file& f, uint64_t offset, uint64_t n, P... p)
+{
+#if defined(__linux__)
+    if(detail::is_plain_stream(s))
+    {
+        auto& sock = detail::lowest_socket(s);
+
+        aerror_code e;
+        detail::scoped_native_non_blocking nb(sock, e);
+        if(e)
+            co_return e;
+
+        auto     off  = static_cast<off_t>(offset);
+        uint64_t sent = 0;
+
+        while(sent < n)
+        {
+            // sendfile transfers at most 0x7ffff000 bytes at once
+            ssize_t r = ::sendfile(sock.native_handle(), f.native_handle(), &off,
+                                   static_cast<size_t>((std::min<uint64_t>)(n - sent, 0x7ffff000)));
+            if(r > 0)
+            {
+                sent += static_cast<uint64_t>(r);
+                continue;
+            }
+
+            if(r == 0) // eof
+                break;
+
+            int err = errno;
+
+            if(err == EINTR)
+                continue;
+
+            if(err != EAGAIN && err != EWOULDBLOCK)
+                co_return aerror_code(err, asio::error::get_system_category());
+
+            JKL_CO_TRY(co_await detail::wait_socket(s, asio::socket_base::wait_write, p...));
+        }
+
+        co_return sent;
+    }
+#endif
+
+    co_return co_await detail::copy_file_to(s, f, offset, n, p...);
+}
+
+
+// below this, page pinning and notifications cost more than copying
+inline constexpr size_t send_zerocopy_min_size = 16 * 1024;
+
+// sends b with MSG_ZEROCOPY on linux 4.14+, so the kernel transmits pages of b without copying them.
+// returns after the kernel has notified all the pages are released, so b can be reused then.
+// it only pays off for large buffers, so b smaller than send_zerocopy_min_size, TLS streams and
+// systems without MSG_ZEROCOPY fall back to write_all().
+// NOTE: like send_file(), this bypasses timeouts and rate policy of beast::basic_stream.
+
+template<class S, class B, class... P>
+aresult_task<size_t> send_zerocopy(S& s, B const& b, P... p)
+{
+    auto const* data = reinterpret_cast<char const*>(buf_data(b));
+    size_t const size = buf_byte_size(b);
+
+#if defined(__linux__) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+    if(size >= send_zerocopy_min_size && detail::is_plain_stream(s))
+    {
+        auto& sock = detail::lowest_socket(s);
+        int   fd   = sock.native_handle();
+
+        int on = 1;
+
+        if(::setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) == 0)
+        {
+            aerror_code e;
+            detail::scoped_native_non_blocking nb(sock, e);
+            if(e)
+                co_return e;
+
+            size_t   sent  = 0;
+            uint32_t calls = 0; // each successful send() gets a notification id
+            uint32_t done  = 0; // notified ids
+
+            // reads notifications, returns false if there is none for now
+            auto readNotifications = [&]() -> aresult<bool>
+            {
+                char control[128];
+                msghdr msg{};
+                msg.msg_control    = control;
+                msg.msg_controllen = sizeof(control);
+
+                if(::recvmsg(fd, &msg, MSG_ERRQUEUE) == -1)
+                {
+                    int err = errno;
+                    if(err == EAGAIN || err == EWOULDBLOCK || err == EINTR)
+                        return false;
+                    return aerror_code(err, asio::error::get_system_category());
+                }
+
+                for(cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm))
+                {
+                    if(! ((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                          (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+                        continue;
+
+                    auto* ee = reinterpret_cast<sock_extended_err const*>(CMSG_DATA(cm));
+
+                    if(ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                        continue;
+
+                    if(ee->ee_errno)
+                        return aerror_code(static_cast<int>(ee->ee_errno), asio::error::get_system_category());
+
+                    done += ee->ee_data - ee->ee_info + 1; // ids in [ee_info, ee_data] are completed
+                }
+
+                return true;
+            };
+
+            while(sent < size)
+            {
+                ssize_t r = ::send(fd, data + sent, size - sent, MSG_ZEROCOPY | MSG_NOSIGNAL);
+
+                if(r >= 0)
+                {
+                    sent += static_cast<size_t>(r);
+                    ++calls;
+                    continue;
+                }
+
+                int err = errno;
+
+                if(err == EINTR)
+                    continue;
+
+                if(err == EAGAIN || err == EWOULDBLOCK)
+                {
+                    JKL_CO_TRY(co_await detail::wait_socket(s, asio::socket_base::wait_write, p...));
+                }
+                else if(err == ENOBUFS) // too many pending notifications(optmem_max)
+                {
+                    JKL_CO_TRY(co_await detail::wait_notifications(s, readNotifications, p...));
+                }
+                else
+                {
+                    co_return aerror_code(err, asio::error::get_system_category());
+                }
+            }
+
+            while(done < calls)
+            {
+                JKL_CO_TRY(co_await detail::wait_notifications(s, readNotifications, p...));
+            }
+
+            co_return sent;
+        }
+    }
+#endif
+
+    co_return co_await write_all(s, asio::buffer(data, size), p...);
+}
+
+
+
+} // namespace jkl
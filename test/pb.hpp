@@ -3,6 +3,8 @@
 #include <jkl/util/log.hpp>
 #include <jkl/pb/varint.hpp>
 #include <jkl/pb/dsl.hpp>
+#include <jkl/pb/incremental.hpp>
+#include <jkl/pb/stream.hpp>
 #include <unordered_map>
 
 #define DOCTEST_CONFIG_TREAT_CHAR_STAR_AS_STRING
@@ -650,4 +652,697 @@ TEST_CASE("oneof field"){
     auto def = pb_gen_def(sub_msg, msg);
 } // TEST_CASE("oneof field")
 
+
+TEST_CASE("chain write"){
+    struct sub_msg_t
+    {
+        bool                   boolMem = true;
+        std::optional<int32_t> optInt32Mem = -32156411;
+        float                  floatArrMem[2] = {1.226f, 20.1f};
+    };
+
+    constexpr auto sub_msg = pb_message<"sub_msg">(
+        pb_bool             <"boolMem"    , 1>(   JKL_P_VAL(d.boolMem), p_default(false)),
+        pb_int32            <"optInt32Mem", 2>(   JKL_P_VAL(d.optInt32Mem), p_optional),
+        pb_repeated(pb_float<"floatArrMem", 3>(), JKL_P_VAL(d.floatArrMem), JKL_P_CLEAR_VAL(d.floatArrMem[0]=0.f))
+    );
+
+    struct fixed_msg_t
+    {
+        int64_t   sfixed64Mem = -64894313213123;
+        double    doubleArrMem[2] = {-13209386.9832, 124651579.12313};
+        sub_msg_t subMsgArrMem[3];
+    };
+
+    constexpr auto fixed_msg = pb_message<"fixed_msg">(
+        pb_sfixed64                <"sfixed64Mem" , 1>(   JKL_P_VAL(d.sfixed64Mem)),
+        pb_repeated(pb_double      <"doubleArrMem", 2>(), JKL_P_VAL(d.doubleArrMem), JKL_P_CLEAR_VAL(d.doubleArrMem[0]=0)),
+        pb_repeated(sub_msg._      <"subMsgArrMem", 3>(), JKL_P_VAL(d.subMsgArrMem), JKL_P_CLEAR_VAL(d.subMsgArrMem[0].boolMem=false))
+    );
+
+    struct optional_msg_t
+    {
+        std::optional<string>            optStringMem = "some thing";
+        std::optional<std::vector<char>> optDynaBytesMem = std::vector<char>{1, 2, 3, 4, 5, 6};
+        std::optional<sub_msg_t>         optSubMsgMem = sub_msg_t{};
+    };
+
+    constexpr auto optional_msg = pb_message<"optional_msg">(
+        pb_string<"optStringMem"   , 1>(JKL_P_VAL(d.optStringMem), p_optional),
+        pb_bytes <"optDynaBytesMem", 2>(JKL_P_VAL(d.optDynaBytesMem), p_optional),
+        sub_msg._<"optSubMsgMem"   , 3>(JKL_P_VAL(d.optSubMsgMem), p_optional)
+    );
+
+    struct map_msg_t
+    {
+        std::map<int32_t, string>   mapMem1 = {{1, "1"}, {2, "2"}};
+        std::map<string, sub_msg_t> mapMem2 = {{"1", {}}, {"2", {false, 2}}};
+    };
+
+    constexpr auto map_msg = pb_message<"map_msg">(
+        pb_map<"mapMem1", 1>(pb_int32(), pb_string(), JKL_P_VAL(d.mapMem1)),
+        pb_map<"mapMem2", 2>(pb_string(), sub_msg, JKL_P_VAL(d.mapMem2))
+    );
+
+    struct oneof_msg_t
+    {
+        sub_msg_t subMsgMem;
+        std::variant<std::monostate, int32_t, string> oneofMem = "1";
+    };
+
+    constexpr auto oneof_msg = pb_message<"oneof_msg">(
+        sub_msg._<"subMsgMem", 1>(JKL_P_VAL(d.subMsgMem)),
+        pb_oneof<"oneofMem">(
+            pb_int32 <"oneofMemInt", 2>(),
+            pb_string<"oneofMemStr", 3>()
+        )(JKL_P_VAL(d.oneofMem))
+    );
+
+    // one pass chain write produces the same bytes as write(buf, d), when nested messages fit in a block
+    auto check = [](auto const& msg, auto const& d)
+    {
+        std::string buf;
+        CHECK_NOTHROW(msg.write(buf, d));
+
+        std::string chainBuf;
+        pb_chain_buf<> chain;
+        CHECK_NOTHROW(msg.write(chain, d));
+        chain.copy_to(chainBuf);
+        CHECK(chainBuf == buf);
+    };
+
+    std::apply(
+        [&](auto const&... md){ (check(md.first, md.second), ...); },
+        std::tuple{
+            std::pair{fixed_msg   , fixed_msg_t{}},
+            std::pair{optional_msg, optional_msg_t{}},
+            std::pair{optional_msg, optional_msg_t{std::nullopt, std::nullopt, std::nullopt}},
+            std::pair{map_msg     , map_msg_t{}},
+            std::pair{oneof_msg   , oneof_msg_t{}},
+            std::pair{oneof_msg   , oneof_msg_t{{}, 7}}
+        });
+} // TEST_CASE("chain write")
+
+
+TEST_CASE("packed varint field"){
+    struct msg_t
+    {
+        std::vector<int64_t>  int64ArrMem;
+        std::vector<int32_t>  sint32ArrMem;
+        std::vector<uint32_t> uint32ArrMem;
+        bool operator==(msg_t const&) const = default;
+    };
+
+    constexpr auto msg = pb_message<"msg">(
+        pb_repeated(pb_int64 <"int64ArrMem" , 1>(), JKL_P_VAL(d.int64ArrMem )),
+        pb_repeated(pb_sint32<"sint32ArrMem", 2>(), JKL_P_VAL(d.sint32ArrMem)),
+        pb_repeated(pb_uint32<"uint32ArrMem", 3>(), JKL_P_VAL(d.uint32ArrMem))
+    );
+
+    // runs of 1 byte and 2 byte varints mixed with large and negative ones
+    msg_t m;
+    for(int i = 0; i < 1000; ++i)
+    {
+        int64_t v = (i % 100 < 40) ? i % 128 : (i % 100 < 70) ? 128 + i * 13 : (i % 100 < 90) ? -i * 7919 : int64_t(i) << 40;
+        m.int64ArrMem .emplace_back(v);
+        m.sint32ArrMem.emplace_back(static_cast<int32_t>(v));
+        m.uint32ArrMem.emplace_back(static_cast<uint32_t>(v));
+    }
+
+    std::string buf;
+    CHECK_NOTHROW(msg.write(buf, m));
+
+    msg_t readMsg;
+    readMsg.int64ArrMem = {1, 2, 3};
+    CHECK_NOTHROW(msg.full_read(buf, readMsg).throw_on_error());
+    CHECK(readMsg == m);
+
+    // same as decoding one by one
+    std::vector<uint8_t> b;
+    for(auto v : m.int64ArrMem)
+        append_varint(b, v);
+
+    CHECK(count_varints(buf_begin(b), buf_end(b)) == m.int64ArrMem.size());
+
+    std::vector<int64_t> bulk(m.int64ArrMem.size());
+    CHECK(read_varints<false, int64_t>(buf_begin(b), buf_end(b), bulk.data(), bulk.size()).value_or_throw() == buf_end(b));
+    CHECK(bulk == m.int64ArrMem);
+
+    b.pop_back(); // last varint is incomplete
+    CHECK_FALSE(read_varints<false, int64_t>(buf_begin(b), buf_end(b), bulk.data(), bulk.size()));
+
+    // small blocks, so packed fields span blocks and get padded length prefixes
+    pb_chain_buf<> chain(256);
+    CHECK_NOTHROW(msg.write(chain, m));
+    CHECK(chain.block_cnt() > 1);
+    CHECK(chain.byte_size() >= buf.size());
+
+    std::string chainBuf;
+    chain.copy_to(chainBuf);
+    CHECK(chainBuf.size() == chain.byte_size());
+
+    msg_t chainMsg;
+    CHECK_NOTHROW(msg.full_read(chainBuf, chainMsg).throw_on_error());
+    CHECK(chainMsg == m);
+} // TEST_CASE("packed varint field")
+
+TEST_CASE("incremental read"){
+    struct point_t
+    {
+        int32_t x = 0;
+        string  label;
+        bool operator==(point_t const&) const = default;
+    };
+
+    struct msg_t
+    {
+        std::vector<point_t>  points;
+        std::vector<int64_t>  deltas;
+        std::optional<string> name;
+        bool operator==(msg_t const&) const = default;
+    };
+
+    constexpr auto point = pb_message<"point">(
+        pb_int32 <"x"    , 1>(JKL_P_VAL(d.x)),
+        pb_string<"label", 2>(JKL_P_VAL(d.label))
+    );
+
+    constexpr auto msg = pb_message<"msg">(
+        pb_repeated(point._<"points", 1>(), JKL_P_VAL(d.points)),
+        pb_repeated(pb_int64<"deltas", 2>(), JKL_P_VAL(d.deltas)),
+        pb_string<"name", 3>(JKL_P_VAL(d.name), p_optional)
+    );
+
+    msg_t m;
+    for(int i = 0; i < 300; ++i)
+    {
+        m.points.push_back({i * 1000, string(i % 50, 'a')});
+        m.deltas.push_back(i * i * (i % 2 ? 1 : -1));
+    }
+    m.name = "polyline";
+
+    std::string buf;
+    CHECK_NOTHROW(msg.write(buf, m));
+
+    for(size_t chunk : {1, 3, 7, 64, 4096})
+    {
+        msg_t readMsg;
+        readMsg.points.resize(3);
+        pb_incremental_reader r(msg, readMsg);
+
+        for(size_t i = 0; i < buf.size(); i += chunk)
+        {
+            auto n = (std::min)(chunk, buf.size() - i);
+            CHECK(r.feed(buf.data() + i, n).value_or_throw() == n);
+        }
+
+        CHECK_NOTHROW(r.finish().throw_on_error());
+        CHECK(readMsg == m);
+    }
+
+    // length prefixed messages back to back
+    std::string lpBuf;
+    CHECK_NOTHROW(msg.write_len_prefixed(lpBuf, m));
+    size_t const lpSize = lpBuf.size();
+
+    {
+        std::string two = lpBuf;
+        msg_t const m2{{{1, "b"}}, {5}, std::nullopt};
+        std::string second;
+        CHECK_NOTHROW(msg.write_len_prefixed(second, m2));
+        two += second;
+
+        msg_t readMsg;
+        pb_incremental_reader r(msg, readMsg, true);
+
+        size_t used = 0;
+        for(size_t i = 0; ! r.done(); i += 100)
+            used += r.feed(two.data() + i, (std::min<size_t>)(100, two.size() - i)).value_or_throw();
+
+        CHECK(used == lpSize);
+        CHECK(readMsg == m);
+
+        msg_t readMsg2 = m;
+        pb_incremental_reader r2(msg, readMsg2, true);
+        CHECK(r2.feed(two.data() + used, two.size() - used).value_or_throw() == two.size() - used);
+        CHECK(r2.done());
+        CHECK(readMsg2 == m2);
+    }
+
+    // truncated
+    {
+        msg_t readMsg;
+        pb_incremental_reader r(msg, readMsg);
+        CHECK(r.feed(buf.data(), buf.size() - 1));
+        CHECK(r.pending_size() > 0);
+        CHECK(r.finish().error() == pb_err::msg_incomplete);
+    }
+
+    // bounded by maxMsgSize
+    {
+        msg_t readMsg;
+        pb_incremental_reader r(msg, readMsg, true, buf.size() - 1);
+        CHECK(r.feed(lpBuf.data(), lpBuf.size()).error() == pb_err::msg_too_large);
+
+        // a split record declaring more than maxMsgSize, before it's buffered
+        std::string big;
+        CHECK_NOTHROW(msg.write(big, msg_t{{{1, string(1000, 'c')}}, {7}, std::nullopt}));
+
+        msg_t readMsg2;
+        pb_incremental_reader r2(msg, readMsg2, false, 100);
+        CHECK(r2.feed(big.data(), 10).error() == pb_err::msg_too_large);
+        CHECK(r2.pending_size() <= 10);
+
+        msg_t readMsg3;
+        pb_incremental_reader r3(msg, readMsg3, false, 100);
+        CHECK(r3.feed(big.data(), 1).value_or_throw() == 1);
+        CHECK(r3.feed(big.data() + 1, 10).error() == pb_err::msg_too_large);
+    }
+} // TEST_CASE("incremental read")
+
+
+TEST_CASE("view and lazy field"){
+    struct point_t
+    {
+        int32_t x = 0;
+        string  label;
+        bool operator==(point_t const&) const = default;
+    };
+
+    struct msg_t
+    {
+        string                   name;
+        std::vector<uint8_t>     blob;
+        std::vector<std::string> tags;
+        point_t                  pos;
+    };
+
+    struct view_t
+    {
+        std::string_view              name;
+        std::span<uint8_t const>      blob;
+        std::vector<std::string_view> tags;
+        pb_lazy<point_t>              pos;
+    };
+
+    constexpr auto point = pb_message<"point">(
+        pb_int32 <"x"    , 1>(JKL_P_VAL(d.x)),
+        pb_string<"label", 2>(JKL_P_VAL(d.label))
+    );
+
+    constexpr auto msg = pb_message<"msg">(
+        pb_string<"name", 1>(JKL_P_VAL(d.name)),
+        pb_bytes <"blob", 2>(JKL_P_VAL(d.blob)),
+        pb_repeated(pb_string<"tags", 3>(), JKL_P_VAL(d.tags)),
+        point._<"pos", 4>(JKL_P_VAL(d.pos))
+    );
+
+    msg_t const m{"view", {1, 2, 3, 0xff}, {"a", "bc", "def"}, {42, "origin"}};
+
+    std::string buf;
+    CHECK_NOTHROW(msg.write(buf, m));
+
+    auto inBuf = [&](auto const& s){
+        auto* p = reinterpret_cast<char const*>(s.data());
+        return buf.data() <= p && p + s.size() <= buf.data() + buf.size();
+    };
+
+    view_t v;
+    CHECK_NOTHROW(msg.full_read(buf, v).throw_on_error());
+
+    CHECK(v.name == m.name);
+    CHECK(inBuf(v.name));
+    CHECK(std::ranges::equal(v.blob, m.blob));
+    CHECK(inBuf(v.blob));
+    CHECK(std::ranges::equal(v.tags, m.tags));
+    CHECK(inBuf(v.tags[2]));
+
+    CHECK(! v.pos.parsed());
+    CHECK(inBuf(v.pos.bytes()));
+
+    // unparsed lazy field is written as is
+    std::string rawBuf;
+    CHECK_NOTHROW(msg.write(rawBuf, v));
+    CHECK(rawBuf == buf);
+
+    pb_chain_buf<> chain(64);
+    msg.write(chain, v);
+    std::string chainBuf;
+    chain.copy_to(chainBuf);
+    CHECK(chainBuf == buf);
+
+    auto* p = v.pos.get(point).value_or_throw();
+    CHECK(v.pos.parsed());
+    CHECK(*p == m.pos);
+
+    p->x = 7;
+
+    std::string modBuf;
+    CHECK_NOTHROW(msg.write(modBuf, v));
+
+    msg_t readMsg;
+    CHECK_NOTHROW(msg.full_read(modBuf, readMsg).throw_on_error());
+    CHECK(readMsg.pos == point_t{7, "origin"});
+    CHECK(readMsg.tags == m.tags);
+
+    // length past the end, rejected by both copying and view fields
+    std::string const cut = buf.substr(0, 2 + m.name.size() - 1);
+    CHECK(msg.full_read(cut, readMsg).error() == pb_err::invalid_length);
+    CHECK(msg.full_read(cut, v).error() == pb_err::invalid_length);
+} // TEST_CASE("view and lazy field")
+
+
+TEST_CASE("arena read"){
+    struct point_t
+    {
+        int32_t          x = 0;
+        std::pmr::string label;
+        bool operator==(point_t const&) const = default;
+    };
+
+    struct msg_t
+    {
+        std::pmr::vector<point_t>          points;
+        std::pmr::vector<std::pmr::string> tags;
+        std::optional<std::pmr::string>    name;
+        bool operator==(msg_t const&) const = default;
+    };
+
+    constexpr auto point = pb_message<"point">(
+        pb_int32 <"x"    , 1>(JKL_P_VAL(d.x)),
+        pb_string<"label", 2>(JKL_P_VAL(d.label))
+    );
+
+    constexpr auto msg = pb_message<"msg">(
+        pb_repeated(point._<"points", 1>(), JKL_P_VAL(d.points)),
+        pb_repeated(pb_string<"tags", 2>(), JKL_P_VAL(d.tags)),
+        pb_string<"name", 3>(JKL_P_VAL(d.name), p_optional)
+    );
+
+    msg_t m;
+    for(int i = 0; i < 100; ++i)
+    {
+        m.points.push_back({i, std::pmr::string(i % 40, 'p')});
+        m.tags.emplace_back(i % 30, 't');
+    }
+    m.name.emplace("a name long enough to not fit in sso buffer");
+
+    std::string buf;
+    CHECK_NOTHROW(msg.write(buf, m));
+
+    pb_arena arena(256);
+
+    for(int round = 0; round < 2; ++round)
+    {
+        {
+            msg_t readMsg;
+            CHECK_NOTHROW(msg.full_read(buf, readMsg, arena).throw_on_error());
+            CHECK(readMsg == m);
+
+            auto* r = arena.resource();
+            CHECK(readMsg.points.get_allocator().resource() == r);
+            CHECK(readMsg.points[99].label.get_allocator().resource() == r);
+            CHECK(readMsg.tags.get_allocator().resource() == r);
+            CHECK(readMsg.tags[29].get_allocator().resource() == r);
+            CHECK(readMsg.name->get_allocator().resource() == r);
+        }
+
+        arena.release();
+    }
+
+    // no arena
+    msg_t readMsg;
+    CHECK_NOTHROW(msg.full_read(buf, readMsg).throw_on_error());
+    CHECK(readMsg == m);
+    CHECK(readMsg.tags.get_allocator().resource() == std::pmr::get_default_resource());
+} // TEST_CASE("arena read")
+
+
+TEST_CASE("projection"){
+    struct sub_t
+    {
+        int32_t x = 0;
+        bool operator==(sub_t const&) const = default;
+    };
+
+    struct msg_t
+    {
+        int32_t                    a = 0;
+        string                     b;
+        std::vector<int64_t>       c;
+        sub_t                      d;
+        std::variant<std::monostate, int32_t, string> e;
+        bool operator==(msg_t const&) const = default;
+    };
+
+    constexpr auto sub = pb_message<"sub">(
+        pb_int32<"x", 1>(JKL_P_VAL(d.x))
+    );
+
+    constexpr auto msg = pb_message<"msg">(
+        pb_int32 <"a", 1>(JKL_P_VAL(d.a)),
+        pb_string<"b", 2>(JKL_P_VAL(d.b)),
+        pb_repeated(pb_int64<"c", 3>(), JKL_P_VAL(d.c)),
+        sub._<"d", 4>(JKL_P_VAL(d.d)),
+        pb_oneof<"e">(
+            pb_int32 <"e1", 5>(),
+            pb_string<"e2", 6>()
+        )(JKL_P_VAL(d.e))
+    );
+
+    msg_t const m{1, "b", {3, 33}, {4}, string("e")};
+
+    std::string buf;
+    CHECK_NOTHROW(msg.write(buf, m));
+
+    constexpr auto proj = msg.project<"c", "e2">();
+    static_assert(std::tuple_size_v<JKL_DECL_NO_CVREF_T(proj.sub_flds())> == 2);
+
+    // a, b, d are required, but not read by the projection, so they are left as is
+    msg_t readMsg{-1, "untouched", {}, {-4}, {}};
+    CHECK_NOTHROW(proj.full_read(buf, readMsg).throw_on_error());
+    CHECK(readMsg == msg_t{-1, "untouched", {3, 33}, {-4}, string("e")});
+
+    CHECK(msg.project<"a">().full_read(buf, readMsg));
+    CHECK(readMsg.a == 1);
+} // TEST_CASE("projection")
+
+
+TEST_CASE("unknown fields"){
+    struct v2_t
+    {
+        int32_t              a = 0;
+        string               b;
+        int64_t              c = 0;
+        string               d;
+        std::vector<int32_t> e;
+        bool operator==(v2_t const&) const = default;
+    };
+
+    struct v1_t
+    {
+        int32_t a = 0;
+        string  b;
+        string  unknown;
+    };
+
+    struct v1_view_t
+    {
+        int32_t a = 0;
+        string  b;
+        std::vector<std::span<uint8_t const>> unknown;
+    };
+
+    constexpr auto v2 = pb_message<"v2">(
+        pb_int32 <"a", 1>(JKL_P_VAL(d.a)),
+        pb_int64 <"c", 3>(JKL_P_VAL(d.c)),
+        pb_string<"b", 2>(JKL_P_VAL(d.b)),
+        pb_string<"d", 4>(JKL_P_VAL(d.d)),
+        pb_repeated(pb_int32<"e", 5>(), JKL_P_VAL(d.e))
+    );
+
+    constexpr auto v1 = pb_message<"v1">(
+        pb_int32 <"a", 1>(JKL_P_VAL(d.a)),
+        pb_string<"b", 2>(JKL_P_VAL(d.b)),
+        pb_unknown_flds(JKL_P_VAL(d.unknown))
+    );
+
+    CHECK(v1.msg_def() == "message v1{\n    required int32 a=1;\n    required string b=2;\n}");
+
+    v2_t const m{1, "b", -3, "d", {5, 55}};
+
+    std::string buf;
+    CHECK_NOTHROW(v2.write(buf, m));
+
+    // copied
+    {
+        v1_t d;
+        d.unknown = "stale";
+        CHECK_NOTHROW(v1.full_read(buf, d).throw_on_error());
+        CHECK(d.unknown.size() > 0);
+
+        d.a = 10;
+        std::string out;
+        CHECK_NOTHROW(v1.write(out, d));
+
+        v2_t r;
+        CHECK_NOTHROW(v2.full_read(out, r).throw_on_error());
+        CHECK(r == v2_t{10, "b", -3, "d", {5, 55}});
+
+        // none
+        std::string v1Buf;
+        CHECK_NOTHROW(v1.write(v1Buf, v1_t{2, "x", {}}));
+        CHECK_NOTHROW(v1.full_read(v1Buf, d).throw_on_error());
+        CHECK(d.unknown.empty());
+    }
+
+    // pointed into input
+    {
+        v1_view_t d;
+        CHECK_NOTHROW(v1.full_read(buf, d).throw_on_error());
+        REQUIRE(d.unknown.size() == 3);
+        CHECK(reinterpret_cast<char const*>(d.unknown[0].data()) > buf.data());
+        CHECK(reinterpret_cast<char const*>(d.unknown[2].data() + d.unknown[2].size()) == buf.data() + buf.size());
+
+        d.b = "bb";
+        pb_chain_buf<> chain;
+        v1.write(chain, d);
+        std::string out;
+        chain.copy_to(out);
+
+        v2_t r;
+        CHECK_NOTHROW(v2.full_read(out, r).throw_on_error());
+        CHECK(r == v2_t{1, "bb", -3, "d", {5, 55}});
+    }
+} // TEST_CASE("unknown fields")
+
+TEST_CASE("stream reader/writer"){
+    // in memory conn, reads at most step bytes each time
+    struct mem_conn
+    {
+        std::string in;
+        size_t      pos   = 0;
+        size_t      step  = 0;
+        size_t      reads = 0;
+        std::string out;
+        size_t      writes = 0;
+
+        aresult_task<size_t> read_some(asio::mutable_buffer b)
+        {
+            ++reads;
+
+            if(pos == in.size())
+                co_return asio::error::eof;
+
+            size_t n = (std::min)({b.size(), step, in.size() - pos});
+            memcpy(b.data(), in.data() + pos, n);
+            pos += n;
+            co_return n;
+        }
+
+        aresult_task<size_t> write_all(std::vector<asio::const_buffer> const& bufs)
+        {
+            ++writes;
+
+            size_t n = 0;
+            for(auto& b : bufs)
+            {
+                out.append(static_cast<char const*>(b.data()), b.size());
+                n += b.size();
+            }
+            co_return n;
+        }
+    };
+
+    struct msg_t
+    {
+        int32_t          a = 0;
+        std::string_view b; // into reader's buffer
+    };
+
+    constexpr auto msg = pb_message<"msg">(
+        pb_int32 <"a", 1>(JKL_P_VAL(d.a)),
+        pb_string<"b", 2>(JKL_P_VAL(d.b))
+    );
+
+    std::string const big(300, 'x');
+
+    auto expected_b = [&](int32_t i)
+    {
+        return (i == 7) ? std::string_view(big) : (i == 10) ? std::string_view("last") : std::string_view("b");
+    };
+
+    mem_conn c;
+
+    // coalesced
+    {
+        pb_stream_writer w(c);
+
+        for(int32_t i = 0; i < 10; ++i)
+            w.enqueue(msg, msg_t{i, expected_b(i)});
+
+        aresult<> r = pb_err::msg_incomplete;
+        spawn([&]() -> atask<>{ r = co_await w.flush(); }());
+        CHECK(r);
+        CHECK(c.writes == 1);
+        CHECK(w.queued_size() == 0);
+
+        r = pb_err::msg_incomplete;
+        spawn([&]() -> atask<>{ r = co_await w.write(msg, msg_t{10, expected_b(10)}); }());
+        CHECK(r);
+        CHECK(c.writes == 2);
+    }
+
+    // small buffer, grows for the large message
+    for(size_t step : {size_t(1), size_t(7), size_t(4096)})
+    {
+        c.in    = c.out;
+        c.pos   = 0;
+        c.step  = step;
+        c.reads = 0;
+
+        pb_stream_reader rd(c, 64);
+
+        for(int32_t i = 0; i <= 10; ++i)
+        {
+            msg_t d;
+            aresult<> r = pb_err::msg_incomplete;
+            spawn([&]() -> atask<>{ r = co_await rd.read(msg, d); }());
+            REQUIRE(r);
+            CHECK(d.a == i);
+            CHECK(d.b == expected_b(i));
+        }
+
+        msg_t d;
+        aresult<> r;
+        spawn([&]() -> atask<>{ r = co_await rd.read(msg, d); }());
+        CHECK(r.error() == asio::error::eof);
+
+        if(step == 4096)
+            CHECK(c.reads < 5);
+    }
+
+    // closed midway
+    {
+        c.in.resize(c.in.size() - 1);
+        c.pos  = 0;
+        c.step = 4096;
+
+        pb_stream_reader rd(c);
+        aresult<> r;
+
+        for(int32_t i = 0; i < 10; ++i)
+        {
+            msg_t d;
+            spawn([&]() -> atask<>{ r = co_await rd.read(msg, d); }());
+            REQUIRE(r);
+        }
+
+        msg_t d;
+        spawn([&]() -> atask<>{ r = co_await rd.read(msg, d); }());
+        CHECK(r.error() == pb_err::msg_incomplete);
+    }
+} // TEST_CASE("stream reader/writer")
+
+
 } // TEST_SUITE("pb")